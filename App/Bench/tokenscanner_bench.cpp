@@ -0,0 +1,176 @@
+/**
+ * @file tokenscanner_bench.cpp
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "tokenscanner.hpp"
+
+/*
+ * Tokenizing throughput of the string stream, per byte loop (the parser
+ * before TokenScanner) against TokenScanner, over lines of the serial text
+ * protocol. Build with -DSIGNALMONITOR_BUILD_BENCHMARKS=ON, run as
+ *
+ *   tokenscanner_bench [MiB]          64 MiB by default
+ *
+ * tokenscanner_bench_scalar is the same with the per byte fallback that
+ * builds without SSE2 get.
+ */
+
+namespace {
+
+struct Result {
+    std::size_t numbers = 0;
+    std::size_t controlWords = 0;
+    double sum = 0;
+
+    bool operator==(const Result&) const = default;
+};
+
+inline bool isGapChar(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\0';
+}
+
+std::string makeInput(std::size_t size) {
+    std::string input;
+    input.reserve(size + 64);
+
+    char line[64];
+    for (std::size_t i = 0; input.size() < size; ++i) {
+        if (i % 1000 == 0)
+            input += "%T 0.001% ";
+
+        auto v = double(i % 10000) / 1000;
+        auto n = std::snprintf(line, sizeof(line), "%.3f %.3f %.3f %.3f\r\n",
+                               v, v + 1, v + 2, v + 3);
+        input.append(line, n);
+    }
+    return input;
+}
+
+template <bool isParsingNumbers>
+Result perByte(const char* begin, const char* end) {
+    Result result;
+    auto cursor = begin;
+    while (cursor != end) {
+        if (isGapChar(*cursor)) {
+            ++cursor;
+            continue;
+        }
+
+        if (*cursor == '%') {
+            auto wordEnd = std::find(cursor + 1, end, '%');
+            if (wordEnd == end)
+                break;
+            ++result.controlWords;
+            cursor = wordEnd + 1;
+            continue;
+        }
+
+        auto wordEnd = std::find_if(cursor, end, isGapChar);
+        if (wordEnd == end)
+            break;
+
+        ++result.numbers;
+        if constexpr (isParsingNumbers) {
+            double value = 0;
+            std::from_chars(cursor, wordEnd, value);
+            result.sum += value;
+        }
+        cursor = wordEnd + 1;
+    }
+    return result;
+}
+
+template <bool isParsingNumbers>
+Result scanner(const char* begin, const char* end) {
+    Result result;
+    TokenScanner scanner{begin, end};
+    auto cursor = begin;
+    while ((cursor = scanner.skipGaps(cursor)) != end) {
+        if (*cursor == '%') {
+            auto wordEnd = scanner.findPercent(cursor + 1);
+            if (wordEnd == end)
+                break;
+            ++result.controlWords;
+            cursor = wordEnd + 1;
+            continue;
+        }
+
+        auto wordEnd = scanner.findGap(cursor);
+        if (wordEnd == end)
+            break;
+
+        ++result.numbers;
+        if constexpr (isParsingNumbers) {
+            double value = 0;
+            std::from_chars(cursor, wordEnd, value);
+            result.sum += value;
+        }
+        cursor = wordEnd + 1;
+    }
+    return result;
+}
+
+/**
+ * @brief best of 5 runs, in MB/s
+ */
+template <typename F>
+double measure(const std::string& input, F&& f, Result& result) {
+    using Clock = std::chrono::steady_clock;
+
+    double best = 0;
+    for (int run = 0; run < 5; ++run) {
+        auto start = Clock::now();
+        result = f(input.data(), input.data() + input.size());
+        std::chrono::duration<double> seconds = Clock::now() - start;
+        best = std::max(best, input.size() / seconds.count() / 1e6);
+    }
+    return best;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::size_t mebibytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    auto input = makeInput(std::max<std::size_t>(mebibytes, 1) << 20);
+
+#if defined(M_TOKENSCANNER_SSE2)
+    const char* classifier = "SSE2";
+#else
+    const char* classifier = "per byte";
+#endif
+    std::printf("%zu MiB, TokenScanner classifier: %s\n\n", input.size() >> 20,
+                classifier);
+    std::printf("%-20s %16s %24s\n", "", "tokenize only",
+                "tokenize + from_chars");
+
+    Result before, beforeParsed, after, afterParsed;
+    auto perByteMBs = measure(input, perByte<false>, before);
+    auto perByteParsedMBs = measure(input, perByte<true>, beforeParsed);
+    auto scannerMBs = measure(input, scanner<false>, after);
+    auto scannerParsedMBs = measure(input, scanner<true>, afterParsed);
+
+    std::printf("%-20s %11.0f MB/s %19.0f MB/s\n", "per byte (before)",
+                perByteMBs, perByteParsedMBs);
+    std::printf("%-20s %11.0f MB/s %19.0f MB/s\n", "TokenScanner",
+                scannerMBs, scannerParsedMBs);
+
+    if (!(before == after) || !(beforeParsed == afterParsed)) {
+        std::printf("\nmismatch: %zu/%zu numbers, %zu/%zu control words\n",
+                    before.numbers, after.numbers, before.controlWords,
+                    after.controlWords);
+        return 1;
+    }
+    return 0;
+}
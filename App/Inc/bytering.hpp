@@ -0,0 +1,117 @@
+/**
+ * @file bytering.hpp
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#ifndef __M_BYTERING_HPP__
+#define __M_BYTERING_HPP__
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+
+/**
+ * @brief Reusable byte buffer written by a reader and consumed in place by
+ * a parser
+ *
+ * The unconsumed bytes [data(), data() + size()) are always contiguous, so
+ * words and frames never have to be stitched across the end of the storage.
+ * Instead of wrapping, prepareWrite() moves the unconsumed tail, at most an
+ * incomplete word or frame, back to the front when the free space at the end
+ * runs out. The storage only grows if the unconsumed bytes plus the write
+ * don't fit. Not thread safe.
+ */
+class ByteRing {
+   public:
+    explicit ByteRing(std::size_t capacity = 0) { reserve(capacity); }
+    ~ByteRing() = default;
+
+    ByteRing(ByteRing&&) noexcept = default;
+    ByteRing& operator=(ByteRing&&) noexcept = default;
+
+    inline std::size_t size() const { return head - tail; }
+    inline std::size_t capacity() const { return storageSize; }
+    inline bool isEmpty() const { return head == tail; }
+
+    /**
+     * @brief first unconsumed byte
+     */
+    inline const char* data() const { return bytes.get() + tail; }
+
+    /**
+     * @brief grow the storage to at least capacity bytes, keeps the data
+     */
+    void reserve(std::size_t capacity) {
+        if (capacity <= storageSize)
+            return;
+
+        capacity = std::bit_ceil(capacity);
+        auto grown = std::make_unique<char[]>(capacity);
+        std::copy_n(data(), size(), grown.get());
+
+        head = size();
+        tail = 0;
+        bytes = std::move(grown);
+        storageSize = capacity;
+    }
+
+    inline void clear() {
+        head = 0;
+        tail = 0;
+    }
+
+    /**
+     * @brief contiguous space for at least n bytes after the data
+     *
+     * @return char* where to write, commitWrite() the bytes written
+     */
+    char* prepareWrite(std::size_t n) {
+        if (storageSize - head < n) {
+            if (size() + n > storageSize) {
+                reserve(size() + n);
+            } else {
+                std::memmove(bytes.get(), data(), size());
+                head = size();
+                tail = 0;
+            }
+        }
+        return bytes.get() + head;
+    }
+    /**
+     * @brief free space at the end, prepareWrite() can hand out that much
+     * without moving anything
+     */
+    inline std::size_t writableSize() const { return storageSize - head; }
+    inline void commitWrite(std::size_t n) { head += n; }
+
+    inline void append(const char* data, std::size_t n) {
+        std::copy_n(data, n, prepareWrite(n));
+        commitWrite(n);
+    }
+
+    /**
+     * @brief drop the first n unconsumed bytes
+     */
+    inline void consume(std::size_t n) {
+        tail += std::min(n, size());
+        // nothing left to keep, the next write starts at the front for free
+        if (tail == head)
+            clear();
+    }
+
+   private:
+    std::unique_ptr<char[]> bytes;
+    std::size_t storageSize = 0;
+    // next write position
+    std::size_t head = 0;
+    // first unconsumed byte
+    std::size_t tail = 0;
+};
+
+#endif /* __M_BYTERING_HPP__ */
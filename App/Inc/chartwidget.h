@@ -14,11 +14,15 @@
 
 #include <QBoxLayout>
 #include <QPair>
+#include <QTimer>
 #include <QVector>
 #include <QWidget>
 
 #include "datasource.h"
 #include "mycustomplot.h"
+#include "replotscheduler.h"
+#include "scope.h"
+#include "spectrogramdatasource.h"
 
 namespace Ui {
 class ChartWidgetToolBar;
@@ -37,6 +41,8 @@ class ChartWidgetToolBar : public QWidget {
 class ChartWidget : public QWidget {
     Q_OBJECT;
 
+    constexpr static auto defaultRetentionMB = 256;
+
    public:
     /**
      * @brief 子图位置(row, col), 从0开始计数
@@ -53,9 +59,13 @@ class ChartWidget : public QWidget {
     void plotRemoved(DataSource::DSID id);
 
    public:
-    QPair<CustomPlot*, QCPGraph*> addPlot(DataSource* ds, DataSource::DSID id,
-                                          PlotPos_t pos = {-1, -1});
-    QCPGraph* insertAtPlot(DataSource::DSID id, PlotPos_t pos);
+    QPair<CustomPlot*, SampleGraph*> addPlot(DataSource* ds,
+                                             DataSource::DSID id,
+                                             PlotPos_t pos = {-1, -1});
+    QPair<CustomPlot*, SpectrogramColorMap*> addSpectrogram(
+        SpectrogramDataSource* ds, DataSource::DSID id,
+        PlotPos_t pos = {-1, -1});
+    SampleGraph* insertAtPlot(DataSource::DSID id, PlotPos_t pos);
 
     void removePlot(PlotPos_t pos);
     void removePlot(DataSource::DSID id);
@@ -77,19 +87,48 @@ class ChartWidget : public QWidget {
 
     bool isDataSourceExist(DataSource::DSID id) const;
 
+    /**
+     * @brief retention of every graph in this widget, current and future
+     */
+    void setRetention(SampleGraph::RetentionPolicy policy, double limit);
+    /**
+     * @brief rows kept by every spectrogram in this widget, current and
+     * future
+     */
+    void setSpectrogramHistory(int rows);
+
    public slots:
     void clearPlot(DataSource::DSID id);
     void clearPlots();
 
    private:
+    /**
+     * @brief create an empty plot and insert it into the layout
+     *
+     * @param pos {-1, -1} means a new column, row -1 means append to column
+     */
+    CustomPlot* createPlot(PlotPos_t pos);
+
     void initLayout();
     void initToolBar();
 
+    /**
+     * @brief pass the frame and trigger settings of the toolbar to scope
+     */
+    void applyScopeSettings();
+    void updateTriggerSources();
+
    private:
     QVector<QPair<CustomPlot*, PlotPos_t>> subplots;
     QHBoxLayout* chartWidgetLayout;
 
     ChartWidgetToolBar* toolBar;
+    Scope* scope;
+
+    SampleGraph::RetentionPolicy retentionPolicy =
+        SampleGraph::KeepMemoryBudget;
+    double retentionLimit = defaultRetentionMB;
+    int spectrogramHistory = SpectrogramColorMap::defaultHistorySize;
 };
 
 #endif /* __M_CHARTWIDGET_H__ */
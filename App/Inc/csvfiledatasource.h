@@ -0,0 +1,68 @@
+/**
+ * @file csvfiledatasource.h
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#ifndef __M_CSVFILEDATASOURCE_H__
+#define __M_CSVFILEDATASOURCE_H__
+
+#include <QString>
+
+#include "datasource.h"
+
+/**
+ * @brief Loads a recorded CSV / TSV capture
+ *
+ * The file is memory mapped and split into chunks at line boundaries which
+ * are parsed in parallel, one thread per core. With two or more columns the
+ * first one is x and every other column becomes a channel, a single column
+ * is y with the row number as x. A non numeric first line is taken as
+ * header.
+ *
+ * The whole capture is published once, sorted by x. The source then stays
+ * idle until requestStopDataSource().
+ */
+class CSVFileDataSource : public DataSource {
+    Q_OBJECT;
+
+    // smaller files are not worth an extra thread
+    constexpr static qint64 minChunkSize = 1 << 20;
+
+   public:
+    explicit CSVFileDataSource(QString path, QObject* parent = nullptr);
+    virtual ~CSVFileDataSource();
+
+   signals:
+    /**
+     * @brief the file is parsed and every channel is published
+     *
+     * @param rows rows read from the file
+     */
+    void loaded(qsizetype rows);
+
+   public slots:
+    virtual void run() override;
+    virtual void requestStopDataSource() override;
+
+   private:
+    /**
+     * @brief parse the mapped file into columns
+     *
+     * @return false if the file has no data
+     */
+    bool parse(const char* begin, const char* end,
+               QVector<QVector<double>>& columns);
+    /**
+     * @brief stable sort every column by the first one, if not sorted yet
+     */
+    static void sortByX(QVector<QVector<double>>& columns);
+
+   private:
+    QString path;
+};
+
+#endif /* __M_CSVFILEDATASOURCE_H__ */
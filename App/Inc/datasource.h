@@ -10,6 +10,7 @@
 #ifndef __M_DATASOURCE_H__
 #define __M_DATASOURCE_H__
 
+#include <QHash>
 #include <QMutex>
 #include <QMutexLocker>
 #include <QObject>
@@ -18,11 +19,18 @@
 #include <QTimer>
 #include <QUuid>
 #include <atomic>
+#include <memory>
+
+#include "sampleblock.h"
+#include "samplestream.h"
 
 /**
  * @brief Data source for chart
  *
- * Run in another thread
+ * Run in another thread. Samples queued by the producer are published every
+ * dataUpdateInterval as one SampleBlock per channel: written into the
+ * SampleStream of every subscriber and shared with derived sources by
+ * dataReceived().
  */
 class DataSource : public QObject {
     Q_OBJECT;
@@ -31,6 +39,7 @@ class DataSource : public QObject {
 
    public:
     using DSID = QUuid;
+    using DropPolicy = SampleStream::DropPolicy;
 
     using DataControlWords = enum {
         DataStreamStart,
@@ -79,9 +88,26 @@ class DataSource : public QObject {
     QVector<DSID> getIds();
     QPair<DataControlWords, QByteArray> parseControlWord(QByteArray data) const;
 
+    /**
+     * @brief open a stream of the samples published on channel id
+     *
+     * The consumer drains it at its own rate, the source drops the stream
+     * once the consumer releases it. Until a channel has its first stream,
+     * the latest defaultCapacity samples published on it are held back and
+     * written into that stream first.
+     *
+     * @return std::shared_ptr<SampleStream> nullptr if id is unknown
+     */
+    std::shared_ptr<SampleStream> subscribe(
+        DSID id, std::size_t capacity = SampleStream::defaultCapacity);
+    /**
+     * @brief drop policy of every stream, current and future
+     */
+    void setDropPolicy(DropPolicy policy);
+
    public slots:
     virtual void run() = 0;
-    inline void requestStopDataSource() { isTerminateSerial = true; };
+    inline virtual void requestStopDataSource() { isTerminateSerial = true; };
     virtual void clearAllData();
 
    signals:
@@ -91,14 +117,13 @@ class DataSource : public QObject {
                              [[maybe_unused]] QByteArray DCWData = {}) const;
 
     /**
-     * @brief send data to chart, updated by updateData() with updateTimer
+     * @brief send data to derived sources, updated by updateData() with
+     * updateTimer. Plots use subscribe() instead
      *
      * @param index data source subplot index
-     * @param x
-     * @param y
+     * @param block published samples, shared by every receiver
      */
-    void dataReceived(qsizetype index, const QVector<double> x,
-                      const QVector<double> y);
+    void dataReceived(qsizetype index, SampleBlockPtr block);
 
     /**
      * @brief emit this signal when datasource request to create a new plot
@@ -112,9 +137,33 @@ class DataSource : public QObject {
     virtual void onControlWordReceived(qsizetype index, DataControlWords words,
                                        QByteArray data);
 
-    void appendData(QVector<double> x, QVector<double> y);
+    /**
+     * @brief queue samples of a channel for the next updateData()
+     *
+     * A block queued into an empty channel is taken over, not copied.
+     */
+    void appendData(qsizetype index, std::shared_ptr<SampleBlock> block);
+    /**
+     * @brief queue samples that replace everything published on a channel
+     * so far, for sources publishing whole frames
+     */
+    void replaceData(qsizetype index, std::shared_ptr<SampleBlock> block);
+    /**
+     * @brief get the pending block of a channel
+     *
+     * Producers append samples straight into it instead of building
+     * temporary blocks.
+     */
+    SampleBlock& channelBuffer(qsizetype index);
     void clearQueuedData();
 
+    /**
+     * @brief append a new channel and assign it an id
+     *
+     * @return qsizetype index of the new channel
+     */
+    qsizetype createChannel();
+
    protected:
     std::atomic<bool> isTerminateSerial = false;
     qsizetype currentSelectedChannel = 0;
@@ -124,9 +173,20 @@ class DataSource : public QObject {
 
    private:
     QTimer* updateTimer;
-    QVector<QVector<double>> dataX, dataY;
+    // pending samples of each channel, published by updateData()
+    QVector<std::shared_ptr<SampleBlock>> pending;
+    // the next publish of a channel resets its streams first
+    QVector<bool> isResetPending;
+    // published samples of each channel without a subscriber yet, kept for
+    // its first one, at most SampleStream::defaultCapacity
+    QVector<SampleBlock> heldBack;
     QVector<DSID> uuid;
     QMutex uuidMutex;
+
+    // subscribers of each channel index
+    QHash<qsizetype, QVector<std::shared_ptr<SampleStream>>> streams;
+    QMutex streamMutex;
+    std::atomic<DropPolicy> dropPolicy = SampleStream::DropOldest;
 };
 
 #endif /* __M_DATASOURCE_H__ */
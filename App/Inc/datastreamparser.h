@@ -11,20 +11,64 @@
 #define __M_DATASTREAMPARSER_H__
 
 #include <QByteArray>
+#include <QByteArrayView>
 #include <QPointF>
 #include <QQueue>
 #include <QVariant>
+#include <cstdint>
+#include <vector>
+
+#include "bytering.hpp"
+#include "sampleblock.h"
 
 class DataStreamParser {
    public:
-    using SourceType = enum class SourceType { StringStream, CSV_File };
+    using SourceType = enum class SourceType {
+        StringStream,
+        CSV_File,
+        BinaryFrame
+    };
     using RDataType = enum class RDataType {
-        RDataPointF,
         RDataControlWord,
         RDataErrorString
     };
 
+    /**
+     * @brief sample type of a binary frame, little endian on the wire
+     *
+     * ControlWord frames carry a text control word (e.g. "%T 0.001%")
+     * instead of samples, count is its length in bytes
+     */
+    using SampleType = enum class SampleType : uint8_t {
+        Int16,
+        UInt16,
+        Int32,
+        Float32,
+        Float64,
+        ControlWord,
+    };
+
     constexpr static auto maxWordSize = 128;
+    // initial size of the parse buffer, it only grows for longer garbage
+    constexpr static auto defaultBufferSize = 64 * 1024;
+
+    /*
+     * Binary frame layout, all fields little endian:
+     *
+     *   u16 sync    frameSyncWord (0x5a 0xa5 on the wire)
+     *   u8  channel subplot index of the samples
+     *   u8  flags   bits 0-3 SampleType, bit 7 frameHasCRCFlag
+     *   u16 count   number of samples, 1..maxFrameSamples
+     *   ... count samples
+     *   u16 crc     only if frameHasCRCFlag, CRC-16/CCITT-FALSE of channel
+     *               to the last sample
+     */
+    constexpr static uint16_t frameSyncWord = 0xa55a;
+    constexpr static uint8_t frameSampleTypeMask = 0x0f;
+    constexpr static uint8_t frameHasCRCFlag = 0x80;
+    constexpr static auto frameHeaderSize = 6;
+    constexpr static auto frameCRCSize = 2;
+    constexpr static auto maxFrameSamples = 4096;
 
     DataStreamParser(SourceType type);
     ~DataStreamParser() = default;
@@ -35,16 +79,112 @@ class DataStreamParser {
      *
      * @param data
      */
-    inline void appendData(const QByteArray& data) { buffer.append(data); }
+    inline void appendData(const QByteArray& data) {
+        buffer.append(data.constData(), data.size());
+    }
+    /**
+     * @brief space for at least size bytes to read into in place, commit
+     * them with commitData()
+     */
+    inline char* prepareData(qsizetype size) {
+        return buffer.prepareWrite(size);
+    }
+    inline void commitData(qsizetype size) { buffer.commitWrite(size); }
+    /**
+     * @brief bytes not parsed yet, valid until the next prepareData()
+     */
+    inline QByteArrayView unparsedData() const {
+        return {buffer.data(), qsizetype(buffer.size())};
+    }
+    /**
+     * @brief drop the first size unparsed bytes without parsing them
+     */
+    inline void dropData(qsizetype size) { buffer.consume(size); }
+    /**
+     * @brief look for %START in the unparsed data, drop what comes before
+     *
+     * @return false if not found yet, the tail that may be the beginning of
+     * a split flag is kept for the next call
+     */
+    bool seekStartFlag();
+
+    /**
+     * @brief samples parsed from now on belong to channel index
+     */
+    void selectChannel(qsizetype index);
+    inline qsizetype selectedChannel() const { return currentSelectIndex; }
+    /**
+     * @brief x step of the samples of the current channel
+     */
+    inline void setChannelStep(qreal newStep) {
+        step[currentSelectIndex] = newStep;
+    }
+    /**
+     * @brief back to channel 0 at x 0 with step 1, for a new stream
+     */
+    void resetChannels();
 
+    inline SourceType sourceType() const { return type; }
     /**
-     * @brief parse data from buffer
+     * @brief change the stream format, drops the unparsed buffer
+     */
+    inline void setSourceType(SourceType newType) {
+        type = newType;
+        buffer.clear();
+        csvDelimiter = 0;
+        csvColumnCount = 0;
+    }
+
+    /**
+     * @brief parse as much of the buffer as possible in one pass
+     *
+     * Data points are appended to block until the buffer is exhausted or a
+     * control word or an error is met, the consumed part of the buffer is
+     * removed once before returning. Points on the x step of the channel
+     * keep the block uniform, x is only stored once it is not.
      *
-     * @param type
+     * @param block pending samples of the current channel
      * @return std::optional<QPair<RDataType, QVariant>>
-     * return std::nullopt if buffer is not enough to parse
+     * the control word or error that stopped parsing, points before it are
+     * already in block. return std::nullopt if the rest of the buffer is not
+     * enough to parse
      */
-    std::optional<QPair<RDataType, QVariant>> parseData();
+    std::optional<QPair<RDataType, QVariant>> parseData(SampleBlock& block);
+
+    /**
+     * @brief guess the delimiter of a delimiter separated values line
+     *
+     * @return the most frequent of ',', '\t' and ';', or ' ' (runs of
+     * blanks) if none of them occurs
+     */
+    static char detectCSVDelimiter(const char* lineBegin, const char* lineEnd);
+    /**
+     * @brief number of fields in a line, 0 for empty and comment lines
+     */
+    static qsizetype countCSVFields(const char* lineBegin, const char* lineEnd,
+                                    char delimiter);
+    /**
+     * @brief whether the first field of a line is not a number
+     */
+    static bool isCSVHeader(const char* lineBegin, const char* lineEnd,
+                            char delimiter);
+    /**
+     * @brief parse lines of [begin, end) into columns
+     *
+     * Every line appends one value to each of columns, empty or missing
+     * fields are NaN and fields past columns.size() are ignored. Empty lines
+     * and lines starting with '#' are skipped.
+     *
+     * @param isEndOfData also parse the last line if it has no '\n'
+     * @param invalidFields incremented for every field that is not a number,
+     * these fields are NaN as well
+     * @return const char* past the last parsed line
+     */
+    static const char* parseCSVLines(const char* begin, const char* end,
+                                     char delimiter,
+                                     QVector<QVector<double>>& columns,
+                                     bool isEndOfData,
+                                     qsizetype& invalidFields);
 
    protected:
     QVector<qreal> x;
@@ -52,13 +192,39 @@ class DataStreamParser {
     qsizetype currentSelectIndex = 0;
 
    private:
-    std::optional<QPair<RDataType, QVariant>> parseAsStringStream();
-    std::optional<QPair<RDataType, QVariant>> parseAsCSVFile();
+    std::optional<QPair<RDataType, QVariant>> parseAsStringStream(
+        SampleBlock& block);
+    std::optional<QPair<RDataType, QVariant>> parseAsCSVFile(
+        SampleBlock& block);
+    /**
+     * @brief decode binary frames, see frameSyncWord
+     *
+     * Bytes that don't start a valid frame header are skipped to resync. A
+     * frame of another channel is not decoded, a "%SUBPLOT n%" control word
+     * is returned instead so the owner switches channel before the next
+     * call.
+     */
+    std::optional<QPair<RDataType, QVariant>> parseAsBinaryFrame(
+        SampleBlock& block);
+    /**
+     * @brief prepare block for samples at the x of the current channel
+     *
+     * @return true if they continue the block uniformly, otherwise x of the
+     * block is stored and the samples need explicit x
+     */
+    bool continueBlock(SampleBlock& block);
 
-    QByteArray buffer = {};
+    ByteRing buffer{defaultBufferSize};
     SourceType type;
     bool isStarted = false;
 
+    // layout of a CSV stream, detected from its first line
+    char csvDelimiter = 0;
+    qsizetype csvColumnCount = 0;
+
+    // samples of a binary frame that can't go into the block directly
+    std::vector<double> decodeBuffer;
+
    private:
     static inline bool isGapChar(char c) {
         return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\0';
@@ -70,6 +236,22 @@ class DataStreamParser {
     static inline bool isNumberInterfixChar(char c) {
         return c == '.' || c == 'e' || c == 'E';
     };
+    static inline qsizetype sampleTypeSize(SampleType type) {
+        switch (type) {
+            case SampleType::Int16:
+            case SampleType::UInt16:
+                return 2;
+            case SampleType::Int32:
+            case SampleType::Float32:
+                return 4;
+            case SampleType::Float64:
+                return 8;
+            case SampleType::ControlWord:
+                return 1;
+            default:
+                return 0;
+        }
+    };
 };
 
 #endif /* __M_DATASTREAMPARSER_H__ */
@@ -11,20 +11,126 @@
 #define __M_FFT_HPP__
 
 #include <complex>
+#include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
 
 using ComplexDouble = std::complex<double>;
 using ComplexArray = std::vector<ComplexDouble>;
 
+/**
+ * @brief Precomputed radix-2 FFT of a fixed power-of-two size
+ *
+ * Twiddle factors and the bit-reversal permutation are computed once in the
+ * constructor, transforms are done in place on caller owned memory and never
+ * allocate.
+ */
+class FFTPlan {
+   public:
+    /**
+     * @brief Construct a plan for transforms of `size` points
+     *
+     * @param size must be zero or a power of two
+     * @throw std::invalid_argument if size is not a power of two
+     */
+    explicit FFTPlan(std::size_t size = 0);
+    ~FFTPlan() = default;
+
+    inline std::size_t size() const { return n; }
+
+    /**
+     * @brief in-place forward transform of size() points
+     */
+    void forward(ComplexDouble* data) const;
+    /**
+     * @brief in-place inverse transform of size() points, NOT scaled by 1/n
+     */
+    void inverse(ComplexDouble* data) const;
+
+   private:
+    template <bool isInverse>
+    void transform(ComplexDouble* data) const;
+
+    std::size_t n = 0;
+    // e^(-2*pi*i*k/n), k in [0, n/2)
+    ComplexArray twiddles;
+    // index pairs (i, j), i < j, swapped by the bit-reversal permutation
+    std::vector<std::pair<uint32_t, uint32_t>> bitReverseSwaps;
+};
+
+/**
+ * @brief Forward FFT of `size` real samples
+ *
+ * The input is packed into size/2 complex points, transformed with a half
+ * sized FFTPlan and untangled into the size/2 + 1 non redundant bins.
+ */
+class RealFFTPlan {
+   public:
+    /**
+     * @param size must be zero or a power of two >= 2
+     * @throw std::invalid_argument if size is not a power of two
+     */
+    explicit RealFFTPlan(std::size_t size = 0);
+    ~RealFFTPlan() = default;
+
+    inline std::size_t size() const { return n; }
+
+    /**
+     * @brief transform size() reals into size()/2 + 1 bins
+     *
+     * @param input size() samples
+     * @param output size()/2 + 1 bins, also used as work buffer
+     */
+    void forward(const double* input, ComplexDouble* output) const;
+
+   private:
+    std::size_t n = 0;
+    FFTPlan halfPlan;
+    // e^(-2*pi*i*k/n), k in [0, n/4]
+    ComplexArray twiddles;
+};
+
 class Fourier {
    private:
    public:
+    using WindowFunction = enum {
+        Rectangular,
+        Hann,
+        Hamming,
+        Blackman,
+    };
+
     Fourier() = default;
     ~Fourier() = default;
 
+    /**
+     * @brief forward transform, inputData.size() must be a power of two
+     */
     static ComplexArray fft(const ComplexArray &inputData);
+    /**
+     * @brief inverse transform (unscaled), inputData.size() must be a power
+     * of two
+     */
     static ComplexArray ifft(const ComplexArray &inputData);
+    /**
+     * @brief forward transform of real input, returns inputData.size()/2 + 1
+     * bins, inputData.size() must be a power of two
+     */
+    static ComplexArray rfft(const std::vector<double> &inputData);
+
+    /**
+     * @brief get a cached plan of the given size for the calling thread
+     */
+    static const FFTPlan &plan(std::size_t size);
+    static const RealFFTPlan &realPlan(std::size_t size);
+
+    /**
+     * @brief periodic window coefficients of the given size, used for
+     * spectral analysis of a segment
+     */
+    static std::vector<double> window(WindowFunction function,
+                                      std::size_t size);
 
     static std::string pretty(const ComplexArray &);
     static std::string prettyComplexDouble(const ComplexDouble &);
@@ -10,35 +10,128 @@
 #ifndef __M_FFTDATASOURCE_H__
 #define __M_FFTDATASOURCE_H__
 
+#include <QElapsedTimer>
+
 #include "datasource.h"
 #include "fft.hpp"
+#include "ringbuffer.hpp"
 
+/**
+ * @brief Spectral engine of one channel of another data source
+ *
+ * The FFT is computed once per frame, every enabled output is published as
+ * its own channel (index = SpectrumOutput) so any number of plots can
+ * subscribe to it by id.
+ *
+ * Frames are only computed when new samples arrived, and at most
+ * frameRate times per second.
+ *
+ * Without averaging every frame transforms the latest fftSize samples. With
+ * Welch averaging a windowed segment is transformed every hopSize samples
+ * and its power spectrum is folded into a linear (last N segments) or
+ * exponential average, frames then only publish the current average.
+ */
 class FFTDataSource : public DataSource {
     Q_OBJECT;
 
     constexpr static auto defalultFFTSize = 1024;
+    constexpr static auto defaultFrameRate = 30;
 
    public:
-    using FFTWorkMode = enum {
+    using SpectrumOutput = enum {
         Amplitude,
         Phase,
+        PowerDB,
+        SpectrumOutputCount,
+    };
+    using AveragingMode = enum {
+        NoAveraging,
+        LinearAveraging,
+        ExponentialAveraging,
     };
 
-    explicit FFTDataSource(FFTWorkMode, DataSource const* otherRegularSource,
+    explicit FFTDataSource(DataSource const* otherRegularSource,
+                           qsizetype sourceChannel = 0,
                            QObject* parent = nullptr);
     virtual ~FFTDataSource();
 
+    inline bool isOutputEnabled(SpectrumOutput output) const {
+        return enabledOutputs[output];
+    }
+
    public slots:
     virtual void run() override;
+    virtual void requestStopDataSource() override;
     void setFFTSize(uint32_t size);
+    void setFrameRate(int fps);
+    void setOutputEnabled(SpectrumOutput output, bool isEnabled);
+    void setWindowFunction(Fourier::WindowFunction function);
+    /**
+     * @brief set the distance between two Welch segments, clamped to
+     * [1, fftSize]
+     */
+    void setHopSize(uint32_t size);
+    /**
+     * @brief select the averaging mode
+     *
+     * @param frames segments in the linear average, or the time constant
+     * (alpha = 1 / frames) of the exponential average
+     */
+    void setAveraging(AveragingMode mode, uint32_t frames);
     virtual void clearAllData() override;
 
    private:
+    /**
+     * @brief start the frame timer so that the next frame is computed no
+     * sooner than one frame interval after the previous one
+     */
+    void scheduleFrame();
+    void processFrame();
+
+    void appendSamples(const double* samples, qsizetype count);
+    /**
+     * @brief transform the windowed latest samples into spectrum
+     */
+    void transformWindow();
+    /**
+     * @brief transform one Welch segment and fold it into the average
+     */
+    void processSegment();
+    void resetAveraging();
+
+   private:
+    QTimer* frameTimer = nullptr;
+    QElapsedTimer lastFrameTime;
+    int frameRate = defaultFrameRate;
+
     qreal step = 0;
     uint32_t fftSize = defalultFFTSize;
-    ComplexArray dataset;
+    qsizetype sourceChannel;
+    // latest fftSize samples
+    RingBuffer<double> dataset{defalultFFTSize};
+    // zero padded transform input and its size/2 + 1 bins, reused by every
+    // frame
+    std::vector<double> frame;
+    ComplexArray spectrum;
+    RealFFTPlan plan{defalultFFTSize};
     bool isDataUpdated = false;
-    FFTWorkMode workMode;
+    bool enabledOutputs[SpectrumOutputCount] = {true, true, false};
+
+    Fourier::WindowFunction windowFunction = Fourier::Rectangular;
+    std::vector<double> window;
+    // sum of window coefficients, normalizes amplitude to the input unit
+    double windowGain = defalultFFTSize;
+
+    AveragingMode averagingMode = NoAveraging;
+    uint32_t averageFrames = 8;
+    uint32_t hopSize = defalultFFTSize;
+    uint32_t samplesSinceHop = 0;
+    // |X|^2 of each bin, averaged over segments
+    std::vector<double> averagedPower;
+    // power spectra of the last averageFrames segments, for linear averaging
+    std::vector<std::vector<double>> powerHistory;
+    std::size_t powerHistoryIndex = 0;
+    std::size_t averagedSegments = 0;
 };
 
 #endif /* __M_FFTDATASOURCE_H__ */
@@ -12,6 +12,7 @@
 
 #include <QCloseEvent>
 #include <QMap>
+#include <QTimer>
 #include <QVector>
 #include <QWidget>
 #include <memory>
@@ -19,7 +20,9 @@
 #include "chartwidget.h"
 #include "datasource.h"
 #include "pch.h"
+#include "readmeter.hpp"
 #include "serial.h"
+#include "sourcethreadpool.h"
 
 namespace Ui {
 class MainWindow;
@@ -61,25 +64,39 @@ class MainWindow : public QWidget {
      * @brief Create a New Plot object
      *
      * @param source
-     * @return QCPGraph* Series Object
+     * @return SampleGraph* Series Object
      */
-    QCPGraph *createNewPlot(DataSource *source, qsizetype index, QString title,
-                            QPen color, NewDataStrategy strategy,
-                            ChartWidget::PlotPos_t pos = {-1, -1});
+    SampleGraph *createNewPlot(DataSource *source, qsizetype index,
+                               QString title, QPen color,
+                               NewDataStrategy strategy,
+                               ChartWidget::PlotPos_t pos = {-1, -1});
 
     void createSerialDataSource(SerialSettings settings,
                                 NewDataStrategy strategy);
+    void createFileDataSource(QString path, NewDataStrategy strategy);
+    /**
+     * @brief show the read rate and read gaps of every native port
+     */
+    void updateReadStatus();
 
    private:
     constexpr static auto aimWidth = 1280;
     constexpr static auto aimHeight = 720;
+    constexpr static auto readStatusInterval = 1000;
 
     Ui::MainWindow *ui;
 
     ChartWidget *currentSelectedPlot = nullptr;
 
+    // the thread is nullptr for sources run by a SourceThreadPool
     QMap<DataSource::DSID, QPair<DataSource *, QThread *>> sourceToThreadMap;
+    SourceThreadPool *acquisitionThreads;
+    SourceThreadPool *computeThreads;
     QVector<ChartWidget *> popUpPlots;
+
+    // fed by SerialWorker::portRead() of each native port, by port name
+    QMap<QString, std::shared_ptr<ReadMeter>> readMeters;
+    QTimer *readStatusTimer;
 };
 
 #endif /* __M_MAINWINDOW_H__ */
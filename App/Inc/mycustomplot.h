@@ -13,6 +13,10 @@
 #include <QEvent>
 #include <QLabel>
 #include <QMap>
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <vector>
 
 #include "datasource.h"
 #include "pch.h"
@@ -28,6 +32,225 @@ class DataLabel : public QLabel {
     void setData(QPair<double, double> data);
 };
 
+/**
+ * @brief Color map of a rolling spectrum history, newest row on top
+ *
+ * Raw row values and their colorized scanlines are both kept in rings of
+ * historySize rows, appending a row only colorizes that row instead of
+ * rebuilding the whole map image. Keys are taken from the rows, values are
+ * the row age in frames (0 is the newest row).
+ */
+class SpectrogramColorMap : public QCPColorMap {
+    Q_OBJECT;
+
+   public:
+    // about the pixel height of a plot, each row costs a float and a pixel
+    // per column
+    constexpr static int defaultHistorySize = 1024;
+
+    SpectrogramColorMap(QCPAxis* keyAxis, QCPAxis* valueAxis);
+    ~SpectrogramColorMap();
+
+    inline int historySize() const { return historyRows; }
+    /**
+     * @brief rows kept, clears the rows so far if it changes
+     */
+    void setHistorySize(int rows);
+
+    void appendRow(const QVector<double>& row, QCPRange keyRange);
+    void clearRows();
+
+   protected:
+    virtual void updateMapImage() override;
+    virtual void draw(QCPPainter* painter) override;
+
+   private:
+    void resetRows(int columns, QCPRange keyRange);
+    void colorizeLine(int line);
+
+   private:
+    int historyRows = defaultHistorySize;
+    int columnCount = 0;
+    int rowCount = 0;
+    // scanline of the newest row, rows get older downwards and wrap around
+    int headLine = 0;
+    // historyRows * columnCount raw values, indexed by scanline
+    std::vector<float> rowValues;
+    std::vector<double> lineBuffer;
+    bool isDataRangeValid = false;
+};
+
+/**
+ * @brief Line graph drawn straight from a SampleBlock
+ *
+ * Uniform samples are stored as t0, dt and y only, half the memory of a
+ * QCPGraph, and the visible index range is found in O(1) instead of a
+ * binary search. Samples with explicit x keep their x, which must be
+ * ascending.
+ *
+ * Dense ranges are drawn as the min/max of every pixel column, taken from a
+ * pyramid of min/max levels that is extended as samples are appended. A
+ * frame costs O(pixels * log n) whatever the history length.
+ *
+ * The history is bounded by a retention policy, the oldest samples beyond
+ * it are dropped in amortized O(1).
+ */
+class SampleGraph : public QCPAbstractPlottable {
+    Q_OBJECT;
+
+   public:
+    using RetentionPolicy = enum {
+        KeepAll,
+        // limit is a number of samples
+        KeepLastSamples,
+        // limit is a span of x, in x axis units
+        KeepLastSpan,
+        // limit is the sample storage in MB
+        KeepMemoryBudget,
+    };
+
+    SampleGraph(QCPAxis* keyAxis, QCPAxis* valueAxis);
+    ~SampleGraph();
+
+    /**
+     * @brief samples of the graph, appended to by the owner, who calls
+     * updateData() afterwards
+     */
+    inline SampleBlock& samples() { return sampleData; }
+    inline const SampleBlock& samples() const { return sampleData; }
+    void clearData();
+    /**
+     * @brief extend the levels by the appended samples and drop the oldest
+     * samples the retention policy doesn't keep
+     *
+     * @param isReset samples() was cleared before appending
+     */
+    void updateData(bool isReset = false);
+    /**
+     * @brief show the samples of other instead, other gets the old ones
+     *
+     * For views that replace whole frames, no sample is copied.
+     */
+    void swapSamples(SampleBlock& other);
+
+    inline RetentionPolicy retentionPolicy() const { return retention; }
+    inline double retentionLimit() const { return limit; }
+    void setRetention(RetentionPolicy policy, double newLimit);
+
+    inline QCPScatterStyle scatterStyle() const { return scatter; }
+    void setScatterStyle(const QCPScatterStyle& style);
+
+    /**
+     * @brief index of the sample with the key nearest to key, -1 if empty
+     */
+    qsizetype findNearest(double key) const;
+    QPointF dataPixelPosition(qsizetype index) const;
+
+    virtual double selectTest(const QPointF& pos, bool onlySelectable,
+                              QVariant* details = nullptr) const override;
+    virtual QCPRange getKeyRange(
+        bool& foundRange,
+        QCP::SignDomain inSignDomain = QCP::sdBoth) const override;
+    virtual QCPRange getValueRange(
+        bool& foundRange, QCP::SignDomain inSignDomain = QCP::sdBoth,
+        const QCPRange& inKeyRange = QCPRange()) const override;
+
+   protected:
+    virtual void draw(QCPPainter* painter) override;
+    virtual void drawLegendIcon(QCPPainter* painter,
+                                const QRectF& rect) const override;
+
+   private:
+    // samples per bucket of the first level, and buckets per bucket above
+    constexpr static qsizetype levelBase = 16;
+
+    /**
+     * @brief min/max of some samples, and the extremes next to zero so the
+     * range of either sign domain is known too
+     */
+    struct MinMax {
+        constexpr static double inf = std::numeric_limits<double>::infinity();
+
+        double min = inf;
+        double max = -inf;
+        double minPositive = inf;
+        double maxNegative = -inf;
+
+        inline bool isEmpty() const { return min > max; }
+        // std::min and std::max keep the first argument on NaN, so NaN
+        // values are skipped
+        inline void add(double value) {
+            min = std::min(min, value);
+            max = std::max(max, value);
+            minPositive = std::min(minPositive, value > 0 ? value : inf);
+            maxNegative = std::max(maxNegative, value < 0 ? value : -inf);
+        }
+        inline void add(const MinMax& other) {
+            min = std::min(min, other.min);
+            max = std::max(max, other.max);
+            minPositive = std::min(minPositive, other.minPositive);
+            maxNegative = std::max(maxNegative, other.maxNegative);
+        }
+        /**
+         * @brief min/max of the samples in domain only
+         */
+        MinMax inDomain(QCP::SignDomain domain) const;
+    };
+
+    /**
+     * @brief bucket i of level k holds the min/max of the samples with
+     * absolute index [i, i + 1) * levelBase^(k + 1)
+     *
+     * Absolute indices count from the last clear, so buckets stay aligned
+     * while the oldest samples are dropped.
+     */
+    struct Level {
+        qsizetype firstBucket = 0;
+        std::deque<MinMax> buckets;
+    };
+
+    /**
+     * @brief drop samples beyond the retention policy
+     */
+    void trim();
+    void resetLevels();
+    /**
+     * @brief fold the samples appended since the last call into the levels
+     */
+    void updateLevels();
+    /**
+     * @brief min/max of samples [begin, end) in O(log n)
+     */
+    MinMax minMax(qsizetype begin, qsizetype end) const;
+
+    /**
+     * @brief [begin, end) of the samples in the key range of the key axis,
+     * plus one on each side so the line leaves the axis rect
+     */
+    QPair<qsizetype, qsizetype> visibleRange() const;
+    /**
+     * @brief pixel positions of the line through [begin, end), NaN values
+     * are kept to break the line
+     *
+     * @return true if the samples were reduced to pixel columns
+     */
+    bool getLineData(qsizetype begin, qsizetype end);
+    void drawLine(QCPPainter* painter) const;
+
+   private:
+    SampleBlock sampleData;
+    std::vector<Level> levels;
+    // absolute index of samples()[0], and of the first sample not folded
+    // into the levels yet
+    qsizetype removedSamples = 0;
+    qsizetype indexedSamples = 0;
+
+    RetentionPolicy retention = KeepAll;
+    double limit = 0;
+    QCPScatterStyle scatter;
+    QVector<QPointF> lineData;
+};
+
 class CustomPlot : public QCustomPlot {
     Q_OBJECT;
 
@@ -36,21 +259,30 @@ class CustomPlot : public QCustomPlot {
     ~CustomPlot();
 
    public:
-    QCPGraph* addDataSource(DataSource::DSID source);
+    SampleGraph* addDataSource(DataSource::DSID source);
+    SpectrogramColorMap* addSpectrogram(DataSource::DSID source);
     void removeDataSource(DataSource::DSID source);
-    QCPGraph* getGraph(DataSource::DSID source);
+    SampleGraph* getGraph(DataSource::DSID source);
+    QList<SampleGraph*> getGraphs() const;
+    QList<SpectrogramColorMap*> getSpectrograms() const;
 
     bool isDataSourceExist(DataSource::DSID source) const;
 
     void setPlotUnit(QByteArray xUnit, QByteArray yUnit);
 
+    /**
+     * @brief clear the data of every graph and spectrogram in this plot
+     */
+    void clearAllData();
+
    private:
     void initChart();
     void initAxis(QStringList axesLabel);
     void initSeries();
 
    private:
-    QMap<DataSource::DSID, QCPGraph*> sourceToGraphMap;
+    QMap<DataSource::DSID, SampleGraph*> sourceToGraphMap;
+    QMap<DataSource::DSID, SpectrogramColorMap*> sourceToSpectrogramMap;
     DataLabel* dataLabel;
 };
 
@@ -0,0 +1,68 @@
+/**
+ * @file readmeter.hpp
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#ifndef __M_READMETER_HPP__
+#define __M_READMETER_HPP__
+
+#include <QtGlobal>
+#include <atomic>
+
+/**
+ * @brief Read rate and read gaps of one port
+ *
+ * record() is fed by SerialWorker::portRead() on the worker thread, take()
+ * is polled by the GUI. Timestamps are nanoseconds of the steady clock.
+ */
+class ReadMeter {
+   public:
+    struct Summary {
+        qint64 reads;
+        qint64 bytes;
+        // longest time between two reads since the last take()
+        qint64 longestGap;
+        // timestamp of the latest read, 0 if there was none yet
+        qint64 lastRead;
+    };
+
+    void record(qint64 bytes, qint64 timestamp) {
+        reads.fetch_add(1, std::memory_order_relaxed);
+        totalBytes.fetch_add(bytes, std::memory_order_relaxed);
+
+        auto last = lastRead.exchange(timestamp, std::memory_order_relaxed);
+        if (last == 0)
+            return;
+
+        auto gap = timestamp - last;
+        auto longest = longestGap.load(std::memory_order_relaxed);
+        while (gap > longest &&
+               !longestGap.compare_exchange_weak(longest, gap,
+                                                 std::memory_order_relaxed))
+            ;
+    }
+
+    /**
+     * @brief counts since the last take(), which start over
+     */
+    Summary take() {
+        return {
+            .reads = reads.exchange(0, std::memory_order_relaxed),
+            .bytes = totalBytes.exchange(0, std::memory_order_relaxed),
+            .longestGap = longestGap.exchange(0, std::memory_order_relaxed),
+            .lastRead = lastRead.load(std::memory_order_relaxed),
+        };
+    }
+
+   private:
+    std::atomic<qint64> reads = 0;
+    std::atomic<qint64> totalBytes = 0;
+    std::atomic<qint64> longestGap = 0;
+    std::atomic<qint64> lastRead = 0;
+};
+
+#endif /* __M_READMETER_HPP__ */
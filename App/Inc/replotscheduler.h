@@ -0,0 +1,82 @@
+/**
+ * @file replotscheduler.h
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#ifndef __M_REPLOTSCHEDULER_H__
+#define __M_REPLOTSCHEDULER_H__
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+
+class QCustomPlot;
+
+/**
+ * @brief Display frame clock shared by every plot of the application
+ *
+ * Plots are marked dirty instead of replotted. Every frame, frameStarted()
+ * lets consumers drain their streams and frameDrained() lets views derive
+ * from what was drained, then each dirty plot is replotted once with
+ * rpQueuedReplot, no matter how many times it was marked. Plots of hidden or
+ * minimized windows stay dirty and are skipped until shown.
+ */
+class ReplotScheduler : public QObject {
+    Q_OBJECT;
+
+   public:
+    constexpr static double fallbackFrameRate = 60;
+
+    static ReplotScheduler* instance();
+
+    /**
+     * @brief frames per second, 0 follows the refresh rate of the primary
+     * screen
+     */
+    void setFrameRate(double hz);
+    double frameRate() const;
+
+    /**
+     * @brief replot plot with the next frame
+     *
+     * @param isRescaleAxes also rescale the axes of plot to its data first
+     */
+    void markDirty(QCustomPlot* plot, bool isRescaleAxes = false);
+
+   signals:
+    /**
+     * @brief emitted at the start of every frame, before dirty plots are
+     * replotted
+     */
+    void frameStarted();
+    /**
+     * @brief emitted after frameStarted(), for views derived from the
+     * drained samples
+     */
+    void frameDrained();
+
+   private:
+    explicit ReplotScheduler(QObject* parent = nullptr);
+    ~ReplotScheduler() = default;
+
+    void updateInterval();
+
+   private slots:
+    void onFrame();
+
+   private:
+    QTimer* frameTimer;
+    double requestedFrameRate = 0;
+
+    // dirty plots, mapped to whether their axes need a rescale
+    QHash<QCustomPlot*, bool> dirtyPlots;
+    // plots whose destruction unmarks them
+    QSet<QCustomPlot*> watchedPlots;
+};
+
+#endif /* __M_REPLOTSCHEDULER_H__ */
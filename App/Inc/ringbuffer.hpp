@@ -0,0 +1,97 @@
+/**
+ * @file ringbuffer.hpp
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#ifndef __M_RINGBUFFER_HPP__
+#define __M_RINGBUFFER_HPP__
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <memory>
+
+/**
+ * @brief Fixed capacity circular buffer keeping the latest capacity() items
+ *
+ * Capacity is rounded up to a power of two so indices are masked instead of
+ * wrapped with a modulo. Not thread safe.
+ */
+template <typename T>
+class RingBuffer {
+   public:
+    explicit RingBuffer(std::size_t capacity = 0) { setCapacity(capacity); }
+    ~RingBuffer() = default;
+
+    RingBuffer(RingBuffer&&) noexcept = default;
+    RingBuffer& operator=(RingBuffer&&) noexcept = default;
+
+    inline std::size_t size() const { return count; }
+    inline std::size_t capacity() const { return mask + 1; }
+    inline bool isEmpty() const { return count == 0; }
+    inline bool isFull() const { return count == capacity(); }
+
+    /**
+     * @brief reallocate the buffer, drops all items
+     */
+    void setCapacity(std::size_t capacity) {
+        capacity = std::bit_ceil(std::max<std::size_t>(capacity, 1));
+        data = std::make_unique<T[]>(capacity);
+        mask = capacity - 1;
+        clear();
+    }
+
+    inline void clear() {
+        head = 0;
+        count = 0;
+    }
+
+    /**
+     * @brief append one item, overwrites the oldest one when full
+     */
+    inline void push(const T& item) {
+        data[head] = item;
+        head = (head + 1) & mask;
+        count = std::min(count + 1, capacity());
+    }
+
+    /**
+     * @brief append n items, only the latest capacity() of them are kept
+     */
+    void push(const T* items, std::size_t n) {
+        if (n >= capacity()) {
+            items += n - capacity();
+            n = capacity();
+        }
+
+        auto firstPart = std::min(n, capacity() - head);
+        std::copy_n(items, firstPart, data.get() + head);
+        std::copy_n(items + firstPart, n - firstPart, data.get());
+
+        head = (head + n) & mask;
+        count = std::min(count + n, capacity());
+    }
+
+    /**
+     * @brief copy all items, oldest first, into out[0, size())
+     */
+    void copyTo(T* out) const {
+        auto tail = (head - count) & mask;
+        auto firstPart = std::min(count, capacity() - tail);
+        std::copy_n(data.get() + tail, firstPart, out);
+        std::copy_n(data.get(), count - firstPart, out + firstPart);
+    }
+
+   private:
+    std::unique_ptr<T[]> data;
+    std::size_t mask = 0;
+    // next write position
+    std::size_t head = 0;
+    std::size_t count = 0;
+};
+
+#endif /* __M_RINGBUFFER_HPP__ */
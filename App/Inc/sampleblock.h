@@ -0,0 +1,179 @@
+/**
+ * @file sampleblock.h
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#ifndef __M_SAMPLEBLOCK_H__
+#define __M_SAMPLEBLOCK_H__
+
+#include <QMetaType>
+#include <QtGlobal>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+/**
+ * @brief allocator of cache line aligned storage
+ */
+template <typename T, std::size_t alignment = 64>
+struct CacheAlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = CacheAlignedAllocator<U, alignment>;
+    };
+
+    CacheAlignedAllocator() = default;
+    template <typename U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U, alignment>&) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(
+            ::operator new(n * sizeof(T), std::align_val_t{alignment}));
+    }
+    void deallocate(T* p, std::size_t) {
+        ::operator delete(p, std::align_val_t{alignment});
+    }
+
+    template <typename U>
+    bool operator==(const CacheAlignedAllocator<U, alignment>&) const {
+        return true;
+    }
+};
+
+/**
+ * @brief Contiguous samples of one channel
+ *
+ * y is always stored. x is implicit (x = t0 + i * dt) for uniformly sampled
+ * data and only stored for data with arbitrary x, so equally spaced streams
+ * never build an x array unless a consumer asks for one.
+ *
+ * A block is filled by its producer and then published as SampleBlockPtr,
+ * after which it is immutable and shared by every consumer without copies.
+ */
+class SampleBlock {
+   public:
+    using Buffer = std::vector<double, CacheAlignedAllocator<double>>;
+
+    /**
+     * @brief empty uniform block, x = t0 + i * dt
+     */
+    explicit SampleBlock(qsizetype channel = 0, double t0 = 0, double dt = 1);
+    SampleBlock(const SampleBlock&) = default;
+    SampleBlock(SampleBlock&&) = default;
+    SampleBlock& operator=(const SampleBlock&) = default;
+    SampleBlock& operator=(SampleBlock&&) = default;
+    ~SampleBlock() = default;
+
+    inline qsizetype channel() const { return channelIndex; }
+    inline qsizetype size() const { return qsizetype(ys.size()) - head; }
+    inline bool isEmpty() const { return size() == 0; }
+
+    /**
+     * @brief whether x is implicit, t0() and dt() are only valid if so
+     */
+    inline bool isUniform() const { return !isXStored; }
+    inline double t0() const { return x0 + head * step; }
+    inline double dt() const { return step; }
+
+    inline const double* y() const { return ys.data() + head; }
+    /**
+     * @brief stored x, nullptr for uniform blocks
+     */
+    inline const double* x() const {
+        return isXStored ? xs.data() + head : nullptr;
+    }
+    inline double xAt(qsizetype i) const {
+        return isXStored ? xs[head + i] : x0 + (head + i) * step;
+    }
+    /**
+     * @brief write x of samples [first, first + n) to out
+     */
+    void copyX(qsizetype first, qsizetype n, double* out) const;
+
+    /**
+     * @brief index of the first sample with x >= key, x must be ascending
+     *
+     * O(1) for uniform blocks, a binary search otherwise
+     */
+    qsizetype lowerBound(double key) const;
+    /**
+     * @brief index of the first sample with x > key, see lowerBound()
+     */
+    qsizetype upperBound(double key) const;
+
+    /*
+     * producer side, only before the block is published
+     */
+    void reserve(qsizetype n);
+    void clear();
+    /**
+     * @brief make an empty block uniform with the given x spacing
+     */
+    void setUniform(double t0, double dt);
+    /**
+     * @brief whether uniform samples starting at firstX with spacing dt
+     * extend this block without storing x
+     *
+     * firstX may be off by a thousandth of dt, producers accumulate x and
+     * drift from t0 + i * dt by rounding.
+     */
+    bool isContinuedBy(double firstX, double dt) const;
+    /**
+     * @brief store x of the samples so far, later samples need explicit x
+     */
+    void materializeX();
+
+    /**
+     * @brief append a sample at the next implicit x, block must be uniform
+     */
+    inline void append(double y) { ys.push_back(y); }
+    /**
+     * @brief append n samples at the next implicit x, block must be uniform
+     *
+     * @return double* where the y of the new samples go
+     */
+    double* appendY(qsizetype n);
+    /**
+     * @brief append a sample with explicit x, stores x if not yet done
+     */
+    void append(double x, double y);
+    void append(const double* x, const double* y, qsizetype n);
+    /**
+     * @brief append the samples of other, stays uniform if other continues
+     * this block
+     */
+    void append(const SampleBlock& other);
+
+    /**
+     * @brief drop the first n samples, amortized O(1) per sample
+     *
+     * Only an offset moves, the storage is compacted once the dropped part
+     * outgrows the kept one. Storage may thus hold up to twice size()
+     * samples.
+     */
+    void removeFirst(qsizetype n);
+
+   private:
+    qsizetype channelIndex;
+    double x0;
+    double step;
+    bool isXStored = false;
+
+    // samples before head are removed, x0 is the x of ys[0]
+    qsizetype head = 0;
+    Buffer ys;
+    Buffer xs;
+};
+
+using SampleBlockPtr = std::shared_ptr<const SampleBlock>;
+
+Q_DECLARE_METATYPE(SampleBlockPtr)
+
+#endif /* __M_SAMPLEBLOCK_H__ */
@@ -0,0 +1,147 @@
+/**
+ * @file samplestream.h
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#ifndef __M_SAMPLESTREAM_H__
+#define __M_SAMPLESTREAM_H__
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "sampleblock.h"
+#include "spscring.hpp"
+
+/**
+ * @brief Samples of one channel on their way from a data source to one
+ * consumer
+ *
+ * The data source thread write()s published blocks, the consumer read()s at
+ * its own rate. The ring carries the shared immutable blocks themselves, so
+ * uniform blocks travel as t0/dt and their y only and nothing is copied on
+ * the way. capacity() bounds the queued samples. A write that doesn't fit is
+ * handled by the drop policy and counted, the producer never waits on the
+ * consumer unless the policy is Block.
+ */
+class SampleStream {
+   public:
+    using DropPolicy = enum {
+        // drop the oldest unread blocks to make room
+        DropOldest,
+        // wait until the consumer made room
+        Block,
+        // keep every n-th sample of the write so that it fits
+        Decimate,
+    };
+
+    constexpr static std::size_t defaultCapacity = 1 << 18;
+    // unread writes, a consumer reads every one of them at once
+    constexpr static std::size_t blockCapacity = 1024;
+
+    explicit SampleStream(std::size_t capacity = defaultCapacity,
+                          DropPolicy policy = DropOldest);
+    ~SampleStream();
+
+    SampleStream(const SampleStream&) = delete;
+    SampleStream& operator=(const SampleStream&) = delete;
+
+    /**
+     * @brief samples that can be queued
+     */
+    inline std::size_t capacity() const { return sampleCapacity; }
+    inline DropPolicy dropPolicy() const { return policy; }
+    inline void setDropPolicy(DropPolicy newPolicy) { policy = newPolicy; }
+
+    /**
+     * @brief samples lost by DropOldest or by a canceled Block
+     */
+    inline uint64_t droppedSamples() const { return dropped; }
+    /**
+     * @brief samples skipped by Decimate
+     */
+    inline uint64_t decimatedSamples() const { return decimated; }
+    /**
+     * @brief number of writes that didn't fit
+     */
+    inline uint64_t overflowCount() const { return overflows; }
+
+    /**
+     * @brief producer: queue block as is
+     *
+     * Only a write that has to be trimmed or decimated is copied into a new
+     * block.
+     *
+     * @param isCanceled polled while a Block write waits, the write is
+     * dropped once it returns true
+     */
+    void write(SampleBlockPtr block, const std::function<bool()>& isCanceled);
+    /**
+     * @brief producer: the samples written after this call replace all
+     * samples before it
+     */
+    void reset();
+
+    /**
+     * @brief consumer: append every unread sample to out
+     *
+     * out is cleared first if a reset() came in since the last read. Uniform
+     * blocks keep out uniform as long as they continue it, so a uniform
+     * channel never stores x on the consumer side either.
+     *
+     * @param isReset set to whether out was cleared
+     * @return true if out changed
+     */
+    bool read(SampleBlock& out, bool* isReset = nullptr);
+
+   private:
+    /**
+     * @brief queue block, waits for room if policy is Block
+     *
+     * @return false if it was dropped
+     */
+    bool push(SampleBlockPtr block, const std::function<bool()>& isCanceled);
+    /**
+     * @brief producer: drop the oldest unread block
+     *
+     * @return std::size_t its samples, 0 if there was none
+     */
+    std::size_t discardOldest();
+
+    /**
+     * @brief whether n more samples fit, any block fits an empty queue
+     */
+    inline bool hasRoomFor(std::size_t n) const {
+        auto size = queued.load(std::memory_order_acquire);
+        return ring.size() < ring.capacity() &&
+               (size == 0 || size + n <= sampleCapacity);
+    }
+
+   private:
+    // owned by the ring, freed by whoever takes them out
+    SPSCRing<SampleBlockPtr*> ring;
+    std::size_t sampleCapacity;
+    std::atomic<DropPolicy> policy;
+
+    // samples of the blocks in the ring
+    std::atomic<std::size_t> queued = 0;
+
+    std::atomic<uint64_t> dropped = 0;
+    std::atomic<uint64_t> decimated = 0;
+    std::atomic<uint64_t> overflows = 0;
+
+    // ring index of the first block after the last reset(), blocks before
+    // it are skipped by read()
+    std::atomic<std::size_t> resetIndex = 0;
+    std::size_t readResetIndex = 0;
+
+    // pop buffer of the consumer
+    std::vector<SampleBlockPtr*> readBuffer;
+};
+
+#endif /* __M_SAMPLESTREAM_H__ */
@@ -0,0 +1,153 @@
+/**
+ * @file scope.h
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#ifndef __M_SCOPE_H__
+#define __M_SCOPE_H__
+
+#include <QHash>
+#include <QObject>
+#include <QVector>
+
+#include "mycustomplot.h"
+#include "sampleblock.h"
+#include "samplestream.h"
+
+/**
+ * @brief Oscilloscope mode of the graphs of a ChartWidget
+ *
+ * While enabled, drained samples go to a bounded acquisition block per
+ * graph instead of the graph. The trigger graph is scanned for the trigger
+ * condition, and once the post trigger part of a frame arrived, the x window
+ * of that frame is copied out of every acquisition block into a
+ * preallocated back frame, which is swapped with the one on display. Graphs
+ * thus always show a whole frame of frameSize samples, with x relative to
+ * the trigger.
+ */
+class Scope : public QObject {
+    Q_OBJECT;
+
+   public:
+    using Slope = enum {
+        // the trigger graph crosses the level upwards
+        Rising,
+        // the trigger graph crosses the level downwards
+        Falling,
+        // the trigger graph is at or above the level, free runs while it is
+        Level,
+    };
+
+    constexpr static qsizetype defaultFrameSize = 4096;
+    constexpr static double defaultPreTrigger = 0.5;
+    // an acquisition never holds more samples than this many frames
+    constexpr static qsizetype acquisitionFrames = 4;
+
+    explicit Scope(QObject* parent = nullptr);
+    ~Scope() = default;
+
+    inline bool isEnabled() const { return isScopeEnabled; }
+    /**
+     * @brief switch between frames and the plain history
+     *
+     * The history on display is put aside while frames are shown and comes
+     * back when scope mode is turned off. Samples that arrived meanwhile are
+     * not added to it.
+     */
+    void setEnabled(bool isEnabled);
+
+    /**
+     * @brief graphs in the order they were added
+     */
+    inline const QVector<SampleGraph*>& graphs() const { return graphOrder; }
+    void addGraph(SampleGraph* graph);
+    void removeGraph(SampleGraph* graph);
+
+    inline SampleGraph* triggerGraph() const { return trigger; }
+    void setTrigger(SampleGraph* graph, Slope slope, double level);
+    /**
+     * @brief frame length in samples of the trigger graph, and the part of
+     * it before the trigger
+     */
+    void setFrame(qsizetype size, double preTriggerRatio);
+    inline qsizetype frameSize() const { return frameLength; }
+
+    /**
+     * @brief drain stream into the acquisition block of graph
+     *
+     * @return true if samples were read
+     */
+    bool read(SampleGraph* graph, SampleStream& stream);
+
+    /**
+     * @brief index of the first sample in [first, block.size()) meeting the
+     * trigger condition, block.size() if there is none
+     *
+     * first must be at least 1, the sample before is compared for edges.
+     */
+    static qsizetype findTrigger(const SampleBlock& block, qsizetype first,
+                                 Slope slope, double level);
+
+   public slots:
+    /**
+     * @brief capture the last complete frame, if any, and drop the samples
+     * no later frame needs
+     */
+    void capture();
+
+   signals:
+    void graphsChanged();
+
+   private:
+    struct Channel {
+        SampleBlock acquisition{};
+        // the frame not on display, filled by the next capture
+        SampleBlock backFrame{};
+        // the plain history of the graph while scope mode is on
+        SampleBlock history{};
+    };
+
+    /**
+     * @brief start over with empty acquisitions and frames
+     */
+    void reset();
+    /**
+     * @brief copy the frame around trigger sample at of the trigger graph
+     * into every back frame and swap it onto display
+     */
+    void captureFrame(qsizetype at);
+    /**
+     * @brief cap every acquisition at acquisitionFrames frames
+     */
+    void dropAcquired();
+    /**
+     * @brief drop what the next frame of the trigger graph no longer needs,
+     * and the same x range of the other graphs
+     */
+    void dropBeforeTrigger();
+
+   private:
+    bool isScopeEnabled = false;
+
+    QVector<SampleGraph*> graphOrder;
+    QHash<SampleGraph*, Channel> channels;
+
+    SampleGraph* trigger = nullptr;
+    Slope triggerSlope = Rising;
+    double triggerLevel = 0;
+
+    qsizetype frameLength = defaultFrameSize;
+    qsizetype preTriggerLength =
+        qsizetype(defaultFrameSize * defaultPreTrigger);
+
+    // acquisition index of the next trigger candidate, and of a trigger
+    // still waiting for its post trigger samples, -1 if none
+    qsizetype scanned = 0;
+    qsizetype pendingTrigger = -1;
+};
+
+#endif /* __M_SCOPE_H__ */
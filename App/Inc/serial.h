@@ -18,11 +18,17 @@
 #include <QPushButton>
 #include <QSerialPort>
 #include <QSerialPortInfo>
+#include <QSocketNotifier>
+#include <QSpinBox>
+#include <QTimer>
 #include <QCheckBox>
+#include <memory>
 #include <optional>
 
-#include "dataStreamParser.h"
+#include "datastreamparser.h"
 #include "datasource.h"
+#include "serialpipeline.h"
+#include "termiosport.h"
 
 struct SerialSettings {
     qint32 baudRate;
@@ -32,8 +38,22 @@ struct SerialSettings {
     QSerialPort::FlowControl flowControl;
     QSerialPortInfo port;
     QString portName;
+    DataStreamParser::SourceType sourceType;
 
     bool isTimeDomainData;
+
+    // a read waits for minReadSize bytes, but no longer than maxReadLatency
+    // ms after the first of them arrived
+    qint64 minReadSize;
+    int maxReadLatency;
+
+    // open the port through termios instead of QSerialPort, Linux only
+    bool isNativeBackend;
+    // read, parse and dispatch on separate threads, see SerialPipeline.
+    // Linux only, always through termios
+    bool isPipelined;
+    // core of the pipeline reader, -1 for any
+    int readerCore;
 };
 
 class SerialSettingsDiag : public QDialog {
@@ -50,19 +70,45 @@ class SerialSettingsDiag : public QDialog {
     QPushButton *bOpenSerial, *bCancel;
     QComboBox *cActivatedPort;
     QComboBox *cBaudRate, *cStopBits, *cDataBits, *cParity, *cFlowControl;
+    QComboBox *cDataFormat;
 
     QCheckBox* cIsTimeDomainData;
+    QCheckBox* cIsNativeBackend = nullptr;
+    QCheckBox* cIsPipelined = nullptr;
+    QSpinBox* sReaderCore = nullptr;
+
+    QSpinBox *sMinReadSize, *sMaxReadLatency;
 
    private:
     void initBtns();
     void initComboBox();
     void initCheckBox();
+    void initSpinBox();
 };
 
+/**
+ * @brief Data source reading a serial port
+ *
+ * Event driven: run() opens the port and returns, reads are done on
+ * readyRead by the event loop of the worker thread, which sleeps while the
+ * port is idle. A read waits for minReadSize bytes or maxReadLatency ms,
+ * whichever comes first.
+ *
+ * On Linux the port can be opened through termios (TermiosPort) instead,
+ * which keeps the byte count and time of every read. Either way the bytes
+ * are read straight into the parse buffer and parsed in place.
+ *
+ * For a single very fast port, the pipelined mode reads and parses on
+ * threads of a SerialPipeline instead, this thread only dispatches what was
+ * parsed.
+ */
 class SerialWorker : public DataSource, public DataStreamParser {
     Q_OBJECT;
 
    public:
+    constexpr static qint64 defaultMinReadSize = 64;
+    constexpr static int defaultMaxReadLatency = 5;
+
     SerialWorker(QObject *parent = nullptr);
     ~SerialWorker();
 
@@ -71,13 +117,71 @@ class SerialWorker : public DataSource, public DataStreamParser {
    public slots:
     virtual void run() override;
     virtual void clearAllData() override;
+    /**
+     * @brief close the port right away, emits finished()
+     */
+    virtual void requestStopDataSource() override;
+
+   signals:
+    /**
+     * @brief bytes of one read of the native port, timestamp in
+     * nanoseconds of TermiosPort::Clock, taken right after the read
+     *
+     * The pipelined mode reports the latest read once per dispatch.
+     */
+    void portRead(qint64 bytes, qint64 timestamp);
 
     protected:
     virtual void onControlWordReceived(qsizetype index, DataControlWords words,
                                        QByteArray data) override;
 
    private:
+    // smallest read, FIONREAD and bytesAvailable() may lag behind the driver
+    constexpr static qint64 minReadChunk = 4096;
+    constexpr static int pipelineStatsInterval = 5000;
+    // ms between two looks at FIONREAD while a short read waits
+    constexpr static int recheckInterval = 1;
+
     bool openSerial();
+    bool openNativeSerial();
+    /**
+     * @brief open the port and start a SerialPipeline on it
+     */
+    bool openPipeline();
+#ifdef Q_OS_LINUX
+    /**
+     * @brief port settings for TermiosPort
+     *
+     * @param path set to the device of the port
+     */
+    TermiosPort::Config nativePortConfig(QString &path);
+    /**
+     * @brief dispatch stage of the pipeline, handles every parsed item
+     */
+    void dispatchParsed();
+    void logPipelineStats();
+#endif
+    bool isPortOpen() const;
+    qint64 bytesAvailable() const;
+    /**
+     * @brief read every byte available from either backend into the parse
+     * buffer
+     *
+     * @return qint64 bytes read, 0 if none, stops the source on error
+     */
+    qint64 readPort();
+
+    void onReadyRead();
+    /**
+     * @brief read and parse every byte available
+     */
+    void readAvailable();
+    /**
+     * @brief parse the buffer up to the next control word or error
+     *
+     * @return false if the rest of the buffer is not complete
+     */
+    bool parseDataAndSend();
 
     // shared data
    private:
@@ -85,8 +189,31 @@ class SerialWorker : public DataSource, public DataStreamParser {
 
     // private non-shared data
    private:
-    QSerialPort *serial;
+    QSerialPort *serial = nullptr;
+#ifdef Q_OS_LINUX
+    std::unique_ptr<TermiosPort> nativePort;
+    // level triggered, muted for recheckInterval at a time while the
+    // latency timer waits
+    QSocketNotifier *readNotifier = nullptr;
+    QTimer *recheckTimer = nullptr;
+    TermiosPort::ReadInfo lastRead{};
+    qint64 readCount = 0;
+    qint64 readBytes = 0;
+
+    std::unique_ptr<SerialPipeline> pipeline;
+    QTimer *dispatchTimer = nullptr;
+    QTimer *statsTimer = nullptr;
+    // a %START dispatched resets the parser of the pipeline by itself
+    bool isDispatching = false;
+    // the latest read reported by portRead()
+    TermiosPort::Clock::time_point lastPipelineRead{};
+#endif
+    // bounds the wait for minReadSize bytes
+    QTimer *latencyTimer = nullptr;
     QMutex mutex;
+
+    bool isStart = false;
+    bool isStopped = false;
 };
 
 #endif /* __M_SERIAL_H__ */
@@ -0,0 +1,199 @@
+/**
+ * @file serialpipeline.h
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#ifndef __M_SERIALPIPELINE_H__
+#define __M_SERIALPIPELINE_H__
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stop_token>
+#include <thread>
+
+#include "datasource.h"
+#include "datastreamparser.h"
+#include "spscring.hpp"
+#include "termiosport.h"
+
+#ifdef Q_OS_LINUX
+
+/**
+ * @brief Three stage acquisition of one fast serial port
+ *
+ * The reader thread, pinned to a core if asked, does nothing but blocking
+ * reads straight into the byte queue, so the tty buffer is drained even
+ * while parsing lags behind. The parser thread turns the bytes into sample
+ * blocks and control words for the item queue. The dispatch stage is the
+ * owner, which pop()s the items on its own thread and queues them into its
+ * DataSource.
+ *
+ * Both queues are bounded lock-free SPSC rings. A stage waiting on a full or
+ * empty queue backs off with a short sleep, stats() tells how often that
+ * happened and how full each queue is.
+ */
+class SerialPipeline {
+   public:
+    // about 2.5 s of a 4 Mbaud port
+    constexpr static std::size_t defaultByteQueueSize = 1 << 20;
+    constexpr static std::size_t defaultItemQueueSize = 1024;
+    constexpr static auto backoff = std::chrono::microseconds{100};
+
+    struct Item {
+        using Kind = enum {
+            Samples,
+            ControlWord,
+            ErrorString,
+            // the port failed, nothing follows
+            PortError,
+        };
+
+        Kind kind;
+        qsizetype channel = 0;
+        std::shared_ptr<SampleBlock> block;
+        DataSource::DataControlWords controlWord = DataSource::UserDefined;
+        QByteArray data;
+        QString errorString;
+    };
+
+    /**
+     * @brief counters of every stage, a stall is one backoff
+     */
+    struct Stats {
+        // reader
+        qint64 reads;
+        qint64 bytesRead;
+        qint64 readerStalls;
+        // bytes of the latest read and when it returned, loaded one after
+        // the other, so they may belong to two consecutive reads
+        qint64 lastReadBytes;
+        TermiosPort::Clock::time_point lastReadTime;
+
+        std::size_t byteQueueSize;
+        std::size_t byteQueuePeak;
+        std::size_t byteQueueCapacity;
+
+        // parser, idle on an empty byte queue, stalled on a full item queue
+        qint64 parsedBytes;
+        qint64 parserIdles;
+        qint64 parserStalls;
+
+        std::size_t itemQueueSize;
+        std::size_t itemQueuePeak;
+        std::size_t itemQueueCapacity;
+
+        // dispatch
+        qint64 dispatchedItems;
+    };
+
+    /**
+     * @param port open in blocking mode, VTIME bounds how long stop() waits
+     * for the reader
+     * @param source parses the control words
+     * @param isStarted false to wait for %START first
+     */
+    SerialPipeline(std::unique_ptr<TermiosPort> port, const DataSource* source,
+                   DataStreamParser::SourceType type, bool isStarted);
+    ~SerialPipeline();
+
+    SerialPipeline(const SerialPipeline&) = delete;
+    SerialPipeline& operator=(const SerialPipeline&) = delete;
+
+    /**
+     * @param readerCore core to pin the reader to, -1 for any
+     * @return false if the reader could not be pinned, it runs anyway
+     */
+    bool start(int readerCore = -1);
+    /**
+     * @brief join the reader and the parser, items not popped are dropped
+     */
+    void stop();
+
+    /**
+     * @brief dispatch: the next item, nullptr if none is ready
+     */
+    std::unique_ptr<Item> pop();
+    /**
+     * @brief the parser restarts at channel 0 before parsing more
+     */
+    inline void requestReset() {
+        isResetRequested.store(true, std::memory_order_release);
+    }
+
+    Stats stats() const;
+
+   private:
+    void readLoop(std::stop_token stopToken);
+    void parseLoop(std::stop_token stopToken);
+
+    /**
+     * @brief push the samples parsed so far, if any
+     */
+    void flushBlock(std::stop_token& stopToken);
+    void applyControlWord(DataSource::DataControlWords words,
+                          const QByteArray& data);
+    /**
+     * @brief wait for room in the item queue, dropped if stopped meanwhile
+     */
+    void push(std::unique_ptr<Item> item, std::stop_token& stopToken);
+
+    /**
+     * @brief count one more by the only thread writing counter
+     */
+    static inline void increase(std::atomic<qint64>& counter,
+                                qint64 n = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + n,
+                      std::memory_order_relaxed);
+    }
+    static inline void updatePeak(std::atomic<std::size_t>& peak,
+                                  std::size_t size) {
+        if (size > peak.load(std::memory_order_relaxed))
+            peak.store(size, std::memory_order_relaxed);
+    }
+
+   private:
+    std::unique_ptr<TermiosPort> port;
+    const DataSource* source;
+
+    SPSCRing<char> bytes{defaultByteQueueSize};
+    SPSCRing<Item*> items{defaultItemQueueSize};
+
+    // parser stage only
+    DataStreamParser parser;
+    std::shared_ptr<SampleBlock> block;
+    bool isStarted;
+
+    std::atomic<bool> isResetRequested = false;
+    // set by the reader before it exits, readerError is written before
+    std::atomic<bool> isReaderFailed = false;
+    QString readerError;
+
+    std::atomic<qint64> reads = 0;
+    std::atomic<qint64> bytesRead = 0;
+    std::atomic<qint64> readerStalls = 0;
+    std::atomic<qint64> lastReadBytes = 0;
+    // TermiosPort::Clock ticks since its epoch
+    std::atomic<TermiosPort::Clock::rep> lastReadTime = 0;
+    std::atomic<std::size_t> byteQueuePeak = 0;
+    std::atomic<qint64> parsedBytes = 0;
+    std::atomic<qint64> parserIdles = 0;
+    std::atomic<qint64> parserStalls = 0;
+    std::atomic<std::size_t> itemQueuePeak = 0;
+    std::atomic<qint64> dispatchedItems = 0;
+
+    // declared last, joined before the members they use are destroyed
+    std::jthread reader;
+    std::jthread parserThread;
+};
+
+#endif /* Q_OS_LINUX */
+
+#endif /* __M_SERIALPIPELINE_H__ */
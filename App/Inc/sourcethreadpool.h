@@ -0,0 +1,65 @@
+/**
+ * @file sourcethreadpool.h
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#ifndef __M_SOURCETHREADPOOL_H__
+#define __M_SOURCETHREADPOOL_H__
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QVector>
+
+#include "datasource.h"
+
+/**
+ * @brief Fixed set of threads shared by event driven data sources
+ *
+ * Every thread runs an event loop, which waits on the port descriptors and
+ * timers of all its sources at once (one epoll or poll set on Linux).
+ * Sources go to the thread with the fewest sources, so the number of threads
+ * stays the same however many sources are started.
+ */
+class SourceThreadPool : public QObject {
+    Q_OBJECT;
+
+   public:
+    SourceThreadPool(QString name, int threadCount, QObject* parent = nullptr);
+    /**
+     * @brief stop every thread, sources still running are deleted with them
+     */
+    ~SourceThreadPool();
+
+    inline int threadCount() const { return int(threads.size()); }
+
+    /**
+     * @brief move source to the least loaded thread and run() it there
+     *
+     * source must not block in run(). The caller deletes it with
+     * deleteLater() once it is done, the pool deletes those left when it
+     * stops.
+     */
+    void start(DataSource* source);
+    /**
+     * @brief start sources on the same thread, for sources that feed each
+     * other with direct connections
+     */
+    void start(const QVector<DataSource*>& sources);
+
+   private:
+    QThread* leastLoadedThread();
+
+   private:
+    QString poolName;
+    QVector<QThread*> threads;
+    // number of sources living in each thread
+    QHash<QThread*, int> load;
+};
+
+#endif /* __M_SOURCETHREADPOOL_H__ */
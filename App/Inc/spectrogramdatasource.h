@@ -0,0 +1,57 @@
+/**
+ * @file spectrogramdatasource.h
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#ifndef __M_SPECTROGRAMDATASOURCE_H__
+#define __M_SPECTROGRAMDATASOURCE_H__
+
+#include "datasource.h"
+
+/**
+ * @brief Turns the frames of a spectrum channel into spectrogram rows
+ *
+ * Every frame of the spectrum source becomes exactly one row of at most
+ * maxColumns cells (max pooled), published with rowReceived().
+ */
+class SpectrogramDataSource : public DataSource {
+    Q_OBJECT;
+
+    constexpr static auto defaultMaxColumns = 1024;
+
+   public:
+    explicit SpectrogramDataSource(DataSource const* spectrumSource,
+                                   qsizetype spectrumChannel,
+                                   QObject* parent = nullptr);
+    virtual ~SpectrogramDataSource();
+
+   public slots:
+    virtual void run() override;
+    virtual void requestStopDataSource() override;
+    void setMaxColumns(int columns);
+
+   signals:
+    /**
+     * @brief one new spectrogram row, emitted once per spectrum frame
+     *
+     * @param index data source channel index
+     * @param keyLower key (frequency) of the first cell
+     * @param keyUpper key (frequency) of the last cell
+     * @param row cell values
+     */
+    void rowReceived(qsizetype index, double keyLower, double keyUpper,
+                     QVector<double> row);
+
+   private:
+    void appendSpectrum(const SampleBlock& spectrum);
+
+   private:
+    qsizetype spectrumChannel;
+    int maxColumns = defaultMaxColumns;
+};
+
+#endif /* __M_SPECTROGRAMDATASOURCE_H__ */
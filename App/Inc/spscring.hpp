@@ -0,0 +1,172 @@
+/**
+ * @file spscring.hpp
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#ifndef __M_SPSCRING_HPP__
+#define __M_SPSCRING_HPP__
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+/**
+ * @brief Lock-free single producer single consumer ring of trivially
+ * copyable items
+ *
+ * head and tail are free running counters, capacity is rounded up to a power
+ * of two. Besides push(), the producer may discard() the oldest items to make
+ * room, so the consumer commits a pop() with a CAS on tail and copies again
+ * if the producer dropped items under it (the copy of overwritten slots is
+ * thrown away, as in a seqlock).
+ */
+template <typename T>
+class SPSCRing {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    constexpr static std::size_t cacheLineSize = 64;
+
+   public:
+    explicit SPSCRing(std::size_t capacity) {
+        capacity = std::bit_ceil(std::max<std::size_t>(capacity, 1));
+        data = std::make_unique<T[]>(capacity);
+        mask = capacity - 1;
+    }
+    ~SPSCRing() = default;
+
+    SPSCRing(const SPSCRing&) = delete;
+    SPSCRing& operator=(const SPSCRing&) = delete;
+
+    inline std::size_t capacity() const { return mask + 1; }
+    /**
+     * @brief items ready to pop, exact only on the consumer side
+     */
+    inline std::size_t size() const {
+        auto t = tail.load(std::memory_order_acquire);
+        return head.load(std::memory_order_acquire) - t;
+    }
+    /**
+     * @brief producer: index the next pushed item will get
+     */
+    inline std::size_t writeIndex() const {
+        return head.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief producer: append up to n items
+     *
+     * @return std::size_t items appended, less than n if the ring is full
+     */
+    std::size_t push(const T* items, std::size_t n) {
+        auto h = head.load(std::memory_order_relaxed);
+        auto free = capacity() - (h - tail.load(std::memory_order_acquire));
+        n = std::min(n, free);
+
+        auto offset = h & mask;
+        auto firstPart = std::min(n, capacity() - offset);
+        std::copy_n(items, firstPart, data.get() + offset);
+        std::copy_n(items + firstPart, n - firstPart, data.get());
+
+        head.store(h + n, std::memory_order_release);
+        return n;
+    }
+
+    /**
+     * @brief producer: free slots to write into in place, publish them with
+     * commit()
+     *
+     * @param n set to the number of contiguous free slots, less than the
+     * free space when it wraps around the end of the storage
+     */
+    T* writeSpan(std::size_t& n) {
+        auto h = head.load(std::memory_order_relaxed);
+        auto free = capacity() - (h - tail.load(std::memory_order_acquire));
+        auto offset = h & mask;
+
+        n = std::min(free, capacity() - offset);
+        return data.get() + offset;
+    }
+    /**
+     * @brief producer: publish n slots written through writeSpan()
+     */
+    inline void commit(std::size_t n) {
+        head.store(head.load(std::memory_order_relaxed) + n,
+                   std::memory_order_release);
+    }
+
+    /**
+     * @brief producer: drop up to n of the oldest items
+     *
+     * @param out if not null, receives the dropped items, e.g. to free what
+     * they point to
+     * @return std::size_t items dropped
+     */
+    std::size_t discard(std::size_t n, T* out = nullptr) {
+        auto h = head.load(std::memory_order_relaxed);
+        auto t = tail.load(std::memory_order_acquire);
+        std::size_t count;
+        do {
+            count = std::min(n, h - t);
+        } while (!tail.compare_exchange_weak(t, t + count,
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_acquire));
+
+        // only the producer writes slots, they stay intact after the CAS
+        if (out != nullptr) {
+            auto offset = t & mask;
+            auto firstPart = std::min(count, capacity() - offset);
+            std::copy_n(data.get() + offset, firstPart, out);
+            std::copy_n(data.get(), count - firstPart, out + firstPart);
+        }
+        return count;
+    }
+
+    /**
+     * @brief consumer: remove up to n of the oldest items into out
+     *
+     * @param firstIndex set to the index of out[0], see writeIndex()
+     * @return std::size_t items removed
+     */
+    std::size_t pop(T* out, std::size_t n,
+                    std::size_t* firstIndex = nullptr) {
+        auto t = tail.load(std::memory_order_acquire);
+        while (true) {
+            auto count =
+                std::min(n, head.load(std::memory_order_acquire) - t);
+
+            auto offset = t & mask;
+            auto firstPart = std::min(count, capacity() - offset);
+            std::copy_n(data.get() + offset, firstPart, out);
+            std::copy_n(data.get(), count - firstPart, out + firstPart);
+
+            // fails only if the producer discarded items meanwhile, t is
+            // reloaded and the copy is redone
+            if (tail.compare_exchange_weak(t, t + count,
+                                           std::memory_order_acq_rel,
+                                           std::memory_order_acquire)) {
+                if (firstIndex != nullptr)
+                    *firstIndex = t;
+                return count;
+            }
+        }
+    }
+
+   private:
+    std::unique_ptr<T[]> data;
+    std::size_t mask = 0;
+
+    // written by the producer
+    alignas(cacheLineSize) std::atomic<std::size_t> head = 0;
+    // written by the consumer, and by the producer in discard()
+    alignas(cacheLineSize) std::atomic<std::size_t> tail = 0;
+};
+
+#endif /* __M_SPSCRING_HPP__ */
@@ -0,0 +1,132 @@
+/**
+ * @file termiosport.h
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#ifndef __M_TERMIOSPORT_H__
+#define __M_TERMIOSPORT_H__
+
+#include <QString>
+#include <QtGlobal>
+#include <chrono>
+
+#ifdef Q_OS_LINUX
+
+/**
+ * @brief Serial port opened straight through termios, Linux only
+ *
+ * Reads go from the kernel into the buffer of the caller, without the extra
+ * buffer of QSerialPort, and every read tells its byte count and when it
+ * completed. The port is set up for latency: raw mode, ASYNC_LOW_LATENCY
+ * and, for FTDI adapters, the shortest USB latency timer.
+ */
+class TermiosPort {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    using Parity = enum {
+        NoParity,
+        EvenParity,
+        OddParity,
+    };
+
+    struct Config {
+        qint32 baudRate = 115200;
+        int dataBits = 8;
+        Parity parity = NoParity;
+        bool isTwoStopBits = false;
+        bool isHardwareFlowControl = false;
+        bool isSoftwareFlowControl = false;
+
+        /**
+         * @brief whether read() blocks, VMIN and VTIME only apply if so
+         *
+         * A blocking read returns once vmin bytes arrived, or vtime tenths
+         * of a second after the last byte if vtime isn't 0.
+         */
+        bool isBlocking = false;
+        int vmin = 1;
+        int vtime = 0;
+
+        // ask the driver to push every byte to the tty right away
+        bool isLowLatency = true;
+    };
+
+    /**
+     * @brief result of one read()
+     */
+    struct ReadInfo {
+        // -1 on error or hang up, 0 if nothing was available
+        qint64 bytes;
+        Clock::time_point timestamp;
+    };
+
+    TermiosPort() = default;
+    ~TermiosPort();
+
+    TermiosPort(const TermiosPort&) = delete;
+    TermiosPort& operator=(const TermiosPort&) = delete;
+
+    /**
+     * @param path tty device, e.g. /dev/ttyUSB0
+     * @return false if the port can't be opened or set up, see
+     * errorString()
+     */
+    bool open(const QString& path, const Config& config);
+    void close();
+
+    inline bool isOpen() const { return fd >= 0; }
+    /**
+     * @brief file descriptor for readiness notification, -1 if closed
+     */
+    inline int descriptor() const { return fd; }
+    inline QString errorString() const { return lastError; }
+    /**
+     * @brief whether the driver took ASYNC_LOW_LATENCY, ptys don't
+     */
+    inline bool isLowLatency() const { return isLowLatencySet; }
+
+    /**
+     * @brief bytes waiting in the tty input buffer
+     */
+    qint64 bytesAvailable() const;
+    /**
+     * @brief read up to maxSize bytes into data
+     */
+    ReadInfo read(char* data, qint64 maxSize);
+    qint64 write(const char* data, qint64 size);
+
+    /**
+     * @brief termios speed constant of a baud rate, 0 if unsupported
+     */
+    static unsigned speedOf(qint32 baudRate);
+
+   private:
+    bool configure(const Config& config);
+    void setLowLatency();
+    /**
+     * @brief set the latency timer of an FTDI adapter to 1 ms, 16 ms by
+     * default
+     */
+    void setUsbLatencyTimer(const QString& path);
+    bool fail(const QString& what);
+    /**
+     * @brief whether the line hung up, tells a blocking read that returned
+     * nothing after VTIME from one that hit end of file
+     */
+    bool isHungUp() const;
+
+   private:
+    int fd = -1;
+    bool isBlockingMode = false;
+    bool isLowLatencySet = false;
+    QString lastError;
+};
+
+#endif /* Q_OS_LINUX */
+
+#endif /* __M_TERMIOSPORT_H__ */
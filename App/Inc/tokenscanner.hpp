@@ -0,0 +1,165 @@
+/**
+ * @file tokenscanner.hpp
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#ifndef __M_TOKENSCANNER_HPP__
+#define __M_TOKENSCANNER_HPP__
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// M_TOKENSCANNER_NO_SIMD forces the per byte scan, for benchmarks
+#if !defined(M_TOKENSCANNER_NO_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || \
+     (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define M_TOKENSCANNER_SSE2
+#endif
+
+/**
+ * @brief Finds token boundaries of the serial text protocol
+ *
+ * With SSE2, the input is classified 64 bytes at a time into two bit masks,
+ * gap chars (' ', '\n', '\t', '\r', '\0') and '%'. Queries inside the
+ * current block are a shift and a count of trailing zeros. Without SSE2 the
+ * queries test byte by byte, a scalar classifier measured at about half the
+ * speed of that, see App/Bench/tokenscanner_bench.cpp.
+ *
+ * Every query returns at most end.
+ */
+class TokenScanner {
+   public:
+    constexpr static std::size_t blockSize = 64;
+
+    TokenScanner(const char* begin, const char* end) : end{end} {
+#if defined(M_TOKENSCANNER_SSE2)
+        load(begin);
+#endif
+    }
+
+    static inline bool isGapChar(char c) {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\0';
+    }
+
+    /**
+     * @brief first gap char at or after pos, or end
+     */
+    inline const char* findGap(const char* pos) {
+#if defined(M_TOKENSCANNER_SSE2)
+        return find<false>(pos);
+#else
+        return std::find_if(pos, end, isGapChar);
+#endif
+    }
+    /**
+     * @brief first non gap char at or after pos, or end
+     */
+    inline const char* skipGaps(const char* pos) {
+#if defined(M_TOKENSCANNER_SSE2)
+        return find<true>(pos);
+#else
+        return std::find_if_not(pos, end, isGapChar);
+#endif
+    }
+    /**
+     * @brief first '%' at or after pos, or end
+     */
+    inline const char* findPercent(const char* pos) {
+#if defined(M_TOKENSCANNER_SSE2)
+        while (pos < end) {
+            if (pos < block || pos >= block + blockSize)
+                load(pos);
+
+            auto m = percentMask >> (pos - block);
+            if (m != 0)
+                return std::min(pos + std::countr_zero(m), end);
+            pos = block + blockSize;
+        }
+        return end;
+#else
+        return std::find(pos, end, '%');
+#endif
+    }
+
+#if defined(M_TOKENSCANNER_SSE2)
+    /**
+     * @brief classify blockSize bytes starting at p
+     *
+     * @param gap bit i is set if p[i] is a gap char
+     * @param percent bit i is set if p[i] is '%'
+     */
+    static inline void classify(const char* p, uint64_t& gap,
+                                uint64_t& percent) {
+        const auto space = _mm_set1_epi8(' ');
+        const auto lf = _mm_set1_epi8('\n');
+        const auto tab = _mm_set1_epi8('\t');
+        const auto cr = _mm_set1_epi8('\r');
+        const auto zero = _mm_setzero_si128();
+        const auto pct = _mm_set1_epi8('%');
+
+        gap = 0;
+        percent = 0;
+        for (int i = 0; i < 4; ++i) {
+            auto v =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i * 16));
+            auto g = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, lf)),
+                _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(v, tab),
+                                 _mm_cmpeq_epi8(v, cr)),
+                    _mm_cmpeq_epi8(v, zero)));
+            gap |= uint64_t(uint16_t(_mm_movemask_epi8(g))) << (i * 16);
+            percent |= uint64_t(uint16_t(_mm_movemask_epi8(
+                           _mm_cmpeq_epi8(v, pct))))
+                       << (i * 16);
+        }
+    }
+
+   private:
+    template <bool isSkipGap>
+    inline const char* find(const char* pos) {
+        while (pos < end) {
+            if (pos < block || pos >= block + blockSize)
+                load(pos);
+
+            auto m = (isSkipGap ? ~gapMask : gapMask) >> (pos - block);
+            if (m != 0)
+                return std::min(pos + std::countr_zero(m), end);
+            pos = block + blockSize;
+        }
+        return end;
+    }
+
+    void load(const char* pos) {
+        block = pos;
+        if (end - pos >= static_cast<std::ptrdiff_t>(blockSize)) {
+            classify(pos, gapMask, percentMask);
+            return;
+        }
+
+        // short tail, pad with '\0' which is a gap char
+        char tail[blockSize] = {};
+        if (end > pos)
+            std::memcpy(tail, pos, end - pos);
+        classify(tail, gapMask, percentMask);
+    }
+#endif
+
+   private:
+    const char* const end;
+#if defined(M_TOKENSCANNER_SSE2)
+    const char* block = nullptr;
+    uint64_t gapMask = 0;
+    uint64_t percentMask = 0;
+#endif
+};
+
+#endif /* __M_TOKENSCANNER_HPP__ */
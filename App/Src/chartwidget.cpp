@@ -19,37 +19,35 @@ ChartWidgetToolBar::ChartWidgetToolBar(QWidget* parent)
     : QWidget{parent}, ui{new Ui::ChartWidgetToolBar} {
     ui->setupUi(this);
 
-    connect(ui->bToggleScopeMode, &QPushButton::clicked, this,
-            [this](bool isEnabeld) {
-                if (isEnabeld) {
-                    ui->bToggleScopeMode->setText("Scope Mode");
-
-                    // show slider bar
-                    ui->sSlider->show();
-                    ui->sliderLabel->show();
-                } else {
-                    ui->bToggleScopeMode->setText("Normal Mode");
-
-                    // hide slider bar
-                    ui->sSlider->hide();
-                    ui->sliderLabel->hide();
-                }
-            });
+    auto onScopeModeToggled = [this](bool isEnabeld) {
+        ui->bToggleScopeMode->setText(isEnabeld ? "Scope Mode" : "Normal Mode");
+
+        // frame and trigger settings only mean something in scope mode
+        for (auto layout : {ui->horizontalLayout, ui->triggerLayout}) {
+            for (auto i = 0; i < layout->count(); ++i)
+                layout->itemAt(i)->widget()->setVisible(isEnabeld);
+        }
+    };
+    connect(ui->bToggleScopeMode, &QPushButton::toggled, this,
+            onScopeModeToggled);
 
-    ui->bToggleScopeMode->click();
+    onScopeModeToggled(ui->bToggleScopeMode->isChecked());
 }
 ChartWidgetToolBar::~ChartWidgetToolBar() { delete ui; }
 
 ChartWidget::ChartWidget(QWidget* parent)
-    : QWidget{parent}, toolBar{new ChartWidgetToolBar{this}} {
+    : QWidget{parent},
+      toolBar{new ChartWidgetToolBar{this}},
+      scope{new Scope{this}} {
     initLayout();
     initToolBar();
+
+    connect(ReplotScheduler::instance(), &ReplotScheduler::frameDrained,
+            scope, &Scope::capture);
 }
 ChartWidget::~ChartWidget() {}
 
-QPair<CustomPlot*, QCPGraph*> ChartWidget::addPlot(DataSource* ds,
-                                                   DataSource::DSID id,
-                                                   PlotPos_t pos) {
+CustomPlot* ChartWidget::createPlot(PlotPos_t pos) {
     if (pos.second == -1) {
         if (subplots.isEmpty()) {
             pos.second = 0;
@@ -70,7 +68,6 @@ QPair<CustomPlot*, QCPGraph*> ChartWidget::addPlot(DataSource* ds,
     }
 
     auto plot = new CustomPlot{this};
-    auto series = plot->addDataSource(id);
 
     auto chartwidgetHWidgetCount = chartWidgetLayout->count();
     auto chartwidgetVLayout =
@@ -104,21 +101,42 @@ QPair<CustomPlot*, QCPGraph*> ChartWidget::addPlot(DataSource* ds,
         toolBar->show();
     }
 
-    // connect with data source
-    connect(ds, &DataSource::dataReceived, this,
-            [series, ds, id](qsizetype index, QVector<double> x,
-                             const QVector<double> y) {
-                auto requestId = ds->getId(index);
+    return plot;
+}
 
-                if (requestId != id) {
+QPair<CustomPlot*, SampleGraph*> ChartWidget::addPlot(DataSource* ds,
+                                                      DataSource::DSID id,
+                                                      PlotPos_t pos) {
+    auto plot = createPlot(pos);
+    auto series = plot->addDataSource(id);
+    series->setRetention(retentionPolicy, retentionLimit);
+
+    // drain the samples of the data source every display frame, the stream
+    // is released together with the series
+    auto stream = ds->subscribe(id);
+    if (stream == nullptr) {
+        printCurrentTime() << "ChartWidget::addPlot: id is not in source";
+        return {plot, series};
+    }
+
+    // uniform samples stay uniform in the graph, x is never stored for them.
+    // In scope mode the scope takes them and shows them frame by frame
+    scope->addGraph(series);
+    auto scheduler = ReplotScheduler::instance();
+    connect(scheduler, &ReplotScheduler::frameStarted, series,
+            [this, scheduler, series, stream]() {
+                if (scope->isEnabled()) {
+                    scope->read(series, *stream);
                     return;
                 }
 
-                series->addData(x, y, true);
+                bool isReset;
+                if (!stream->read(series->samples(), &isReset))
+                    return;
 
-                series->rescaleAxes();
+                series->updateData(isReset);
 
-                series->parentPlot()->replot();
+                scheduler->markDirty(series->parentPlot(), true);
             });
     connect(ds, &DataSource::controlWordReceived, this,
             [this, series, ds, id](qsizetype index,
@@ -156,7 +174,9 @@ QPair<CustomPlot*, QCPGraph*> ChartWidget::addPlot(DataSource* ds,
                     } break;
 
                     case DataSource::DataControlWords::ClearDatas:
-                        series->setData({}, {});
+                        series->clearData();
+                        ReplotScheduler::instance()->markDirty(
+                            series->parentPlot());
                         break;
                 }
             });
@@ -164,7 +184,32 @@ QPair<CustomPlot*, QCPGraph*> ChartWidget::addPlot(DataSource* ds,
     return {plot, series};
 }
 
-QCPGraph* ChartWidget::insertAtPlot(DataSource::DSID id, PlotPos_t pos) {
+QPair<CustomPlot*, SpectrogramColorMap*> ChartWidget::addSpectrogram(
+    SpectrogramDataSource* ds, DataSource::DSID id, PlotPos_t pos) {
+    auto plot = createPlot(pos);
+    auto spectrogram = plot->addSpectrogram(id);
+    spectrogram->setHistorySize(spectrogramHistory);
+
+    plot->xAxis->setLabel("Frequency (Hz)");
+    plot->yAxis->setLabel("History (frames)");
+
+    connect(ds, &SpectrogramDataSource::rowReceived, this,
+            [spectrogram, ds, id](qsizetype index, double keyLower,
+                                  double keyUpper, QVector<double> row) {
+                if (ds->getId(index) != id) {
+                    return;
+                }
+
+                spectrogram->appendRow(row, {keyLower, keyUpper});
+
+                ReplotScheduler::instance()->markDirty(
+                    spectrogram->parentPlot(), true);
+            });
+
+    return {plot, spectrogram};
+}
+
+SampleGraph* ChartWidget::insertAtPlot(DataSource::DSID id, PlotPos_t pos) {
     auto plot = getPlot(pos);
 
     if (plot == nullptr) {
@@ -237,10 +282,9 @@ void ChartWidget::clearPlot(PlotPos_t pos) {
         return;
     }
 
-    plot->graph()->data()->clear();
+    plot->clearAllData();
 
-    // replot
-    plot->replot();
+    ReplotScheduler::instance()->markDirty(plot);
 }
 void ChartWidget::clearPlot(DataSource::DSID id) {
     if (id == DataSource::DSID{}) {
@@ -340,7 +384,126 @@ void ChartWidget::initLayout() {
     setLayout(layout);
 }
 
+void ChartWidget::setRetention(SampleGraph::RetentionPolicy policy,
+                               double limit) {
+    retentionPolicy = policy;
+    retentionLimit = limit;
+
+    for (auto plot : subplots | std::views::keys) {
+        for (auto graph : plot->getGraphs()) {
+            graph->setRetention(policy, limit);
+        }
+        ReplotScheduler::instance()->markDirty(plot);
+    }
+}
+
+void ChartWidget::setSpectrogramHistory(int rows) {
+    spectrogramHistory = rows;
+
+    for (auto plot : subplots | std::views::keys) {
+        for (auto spectrogram : plot->getSpectrograms()) {
+            spectrogram->setHistorySize(rows);
+        }
+        ReplotScheduler::instance()->markDirty(plot, true);
+    }
+}
+
+void ChartWidget::applyScopeSettings() {
+    auto ui = toolBar->ui;
+
+    auto frameSize = qsizetype{1} << ui->sSlider->value();
+    ui->sliderLabel->setText(QString{"%1 samples"}.arg(frameSize));
+    scope->setFrame(frameSize, ui->sPreTrigger->value() / 100.0);
+
+    auto source = ui->cTriggerSource->currentIndex();
+    scope->setTrigger(source < 0 ? nullptr : scope->graphs()[source],
+                      Scope::Slope(ui->cTriggerSlope->currentIndex()),
+                      ui->sTriggerLevel->value());
+}
+
+void ChartWidget::updateTriggerSources() {
+    auto cTriggerSource = toolBar->ui->cTriggerSource;
+
+    cTriggerSource->blockSignals(true);
+    cTriggerSource->clear();
+    for (auto graph : scope->graphs()) {
+        auto pos =
+            getPlotPos(qobject_cast<CustomPlot*>(graph->parentPlot()));
+        cTriggerSource->addItem(
+            QString{"Plot (%1, %2)"}.arg(pos.first).arg(pos.second));
+    }
+    cTriggerSource->setCurrentIndex(
+        scope->graphs().indexOf(scope->triggerGraph()));
+    cTriggerSource->blockSignals(false);
+}
+
 void ChartWidget::initToolBar() {
+    auto ui = toolBar->ui;
+
+    // scope mode
+    connect(ui->bToggleScopeMode, &QPushButton::toggled, scope,
+            &Scope::setEnabled);
+    connect(ui->sSlider, &QSlider::valueChanged, this,
+            &ChartWidget::applyScopeSettings);
+    connect(ui->sPreTrigger, &QSpinBox::valueChanged, this,
+            &ChartWidget::applyScopeSettings);
+    connect(ui->cTriggerSource, &QComboBox::currentIndexChanged, this,
+            &ChartWidget::applyScopeSettings);
+    connect(ui->cTriggerSlope, &QComboBox::currentIndexChanged, this,
+            &ChartWidget::applyScopeSettings);
+    connect(ui->sTriggerLevel, &QDoubleSpinBox::valueChanged, this,
+            &ChartWidget::applyScopeSettings);
+    connect(scope, &Scope::graphsChanged, this,
+            &ChartWidget::updateTriggerSources);
+    applyScopeSettings();
+
+    // history retention
+    auto cRetention = toolBar->ui->cRetention;
+    auto sRetentionLimit = toolBar->ui->sRetentionLimit;
+
+    // every policy starts from its own default limit
+    connect(cRetention, &QComboBox::currentIndexChanged, this,
+            [this, sRetentionLimit](int index) {
+                auto policy = SampleGraph::RetentionPolicy(index);
+
+                sRetentionLimit->setEnabled(policy != SampleGraph::KeepAll);
+                sRetentionLimit->blockSignals(true);
+                switch (policy) {
+                    case SampleGraph::KeepLastSamples:
+                        sRetentionLimit->setDecimals(0);
+                        sRetentionLimit->setSuffix(" samples");
+                        sRetentionLimit->setValue(1'000'000);
+                        break;
+                    case SampleGraph::KeepLastSpan:
+                        sRetentionLimit->setDecimals(3);
+                        sRetentionLimit->setSuffix(" in x");
+                        sRetentionLimit->setValue(10'000'000);
+                        break;
+                    case SampleGraph::KeepMemoryBudget:
+                        sRetentionLimit->setDecimals(0);
+                        sRetentionLimit->setSuffix(" MB");
+                        sRetentionLimit->setValue(defaultRetentionMB);
+                        break;
+                    default:
+                        sRetentionLimit->setSuffix({});
+                        break;
+                }
+                sRetentionLimit->blockSignals(false);
+
+                setRetention(policy, sRetentionLimit->value());
+            });
+    connect(sRetentionLimit, &QDoubleSpinBox::valueChanged, this,
+            [this](double limit) { setRetention(retentionPolicy, limit); });
+
+    cRetention->setCurrentIndex(retentionPolicy);
+
+    // more rows cost memory and scaling time on every replot, so the
+    // default stays near the plot height unless raised here
+    auto sSpectrogramRows = toolBar->ui->sSpectrogramRows;
+    sSpectrogramRows->setValue(spectrogramHistory);
+    connect(sSpectrogramRows, &QSpinBox::valueChanged, this,
+            &ChartWidget::setSpectrogramHistory);
+
     // set toolbar hide when chartwidgetlayout is empty
     toolBar->hide();
 }
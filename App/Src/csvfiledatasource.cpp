@@ -0,0 +1,224 @@
+/**
+ * @file csvfiledatasource.cpp
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#include "csvfiledatasource.h"
+
+#include <QFile>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "datastreamparser.h"
+#include "pch.h"
+
+CSVFileDataSource::CSVFileDataSource(QString path, QObject* parent)
+    : path{path}, DataSource{parent} {
+    // a recorded capture is worth waiting for, never drop any of it
+    setDropPolicy(SampleStream::Block);
+}
+
+CSVFileDataSource::~CSVFileDataSource() {
+    printCurrentTime() << "CSVFileDataSource::~CSVFileDataSource()";
+}
+
+void CSVFileDataSource::run() {
+    printCurrentTime() << "CSVFileDataSource::run() @"
+                       << QThread::currentThreadId();
+
+    auto failed = [this](QString errorMsg) {
+        emit error(errorMsg);
+        requestStopDataSource();
+    };
+
+    QFile file{path};
+    if (!file.open(QIODevice::ReadOnly))
+        return failed("Can't open file " + path + ": " + file.errorString());
+    if (file.size() == 0)
+        return failed("File is empty: " + path);
+
+    auto mapped = file.map(0, file.size());
+    if (mapped == nullptr)
+        return failed("Can't map file " + path + ": " + file.errorString());
+
+    auto begin = reinterpret_cast<const char*>(mapped);
+    QVector<QVector<double>> columns;
+    auto isParsed = parse(begin, begin + file.size(), columns);
+    file.unmap(mapped);
+    file.close();
+
+    if (!isParsed)
+        return failed("No data in file " + path);
+
+    // a single column is y over the row number, x stays implicit
+    const bool isRowNumbered = columns.size() == 1;
+    if (!isRowNumbered)
+        sortByX(columns);
+
+    const auto rows = columns[0].size();
+    const auto channels = isRowNumbered ? 1 : columns.size() - 1;
+
+    // channel 0 is created by DataSource
+    for (auto channel = 1; channel < channels; ++channel) {
+        auto index = createChannel();
+        emit newDataChannelCreated(index, getId(index));
+    }
+    for (auto channel = 0; channel < channels; ++channel) {
+        auto block = std::make_shared<SampleBlock>(channel);
+        block->reserve(rows);
+        if (isRowNumbered)
+            std::copy(columns[0].cbegin(), columns[0].cend(),
+                      block->appendY(rows));
+        else
+            block->append(columns[0].constData(),
+                          columns[channel + 1].constData(), rows);
+        columns[isRowNumbered ? 0 : channel + 1] = {};
+
+        appendData(channel, std::move(block));
+    }
+
+    printCurrentTime() << "CSVFileDataSource::run() loaded" << rows
+                       << "rows of" << channels << "channels";
+    emit loaded(rows);
+}
+
+void CSVFileDataSource::requestStopDataSource() {
+    DataSource::requestStopDataSource();
+    emit finished();
+}
+
+bool CSVFileDataSource::parse(const char* begin, const char* end,
+                              QVector<QVector<double>>& columns) {
+    // skip the UTF-8 BOM
+    if (end - begin >= 3 && std::memcmp(begin, "\xef\xbb\xbf", 3) == 0)
+        begin += 3;
+
+    // the first non empty line decides the layout and may be a header
+    char delimiter = ' ';
+    qsizetype columnCount = 0;
+    qsizetype lineSize = 1;
+    while (begin != end) {
+        auto lineEnd = std::find(begin, end, '\n');
+        delimiter = DataStreamParser::detectCSVDelimiter(begin, lineEnd);
+        columnCount =
+            DataStreamParser::countCSVFields(begin, lineEnd, delimiter);
+        lineSize = lineEnd - begin + 1;
+
+        auto isHeader = columnCount != 0 && DataStreamParser::isCSVHeader(
+                                                begin, lineEnd, delimiter);
+        if (columnCount != 0 && !isHeader)
+            break;
+
+        columnCount = 0;
+        begin = lineEnd == end ? end : lineEnd + 1;
+    }
+    if (columnCount == 0)
+        return false;
+
+    // split at line boundaries, one chunk per core
+    auto chunkCount = std::clamp<qint64>(
+        (end - begin) / minChunkSize, 1,
+        std::max(std::thread::hardware_concurrency(), 1u));
+
+    QVector<const char*> bounds{begin};
+    for (qint64 chunk = 1; chunk < chunkCount; ++chunk) {
+        auto p = std::max(begin + (end - begin) * chunk / chunkCount,
+                          bounds.last());
+        p = std::find(p, end, '\n');
+        bounds.append(p == end ? end : p + 1);
+    }
+    bounds.append(end);
+
+    QVector<QVector<QVector<double>>> chunkColumns(chunkCount);
+    QVector<qsizetype> invalidFields(chunkCount, 0);
+
+    // workers only touch their own element, take the pointers up front so
+    // no QVector is detached concurrently
+    auto* chunkColumnsData = chunkColumns.data();
+    auto* invalidFieldsData = invalidFields.data();
+    auto* boundsData = bounds.constData();
+    auto parseChunk = [=](qsizetype chunk) {
+        auto& chunkColumn = chunkColumnsData[chunk];
+        chunkColumn.resize(columnCount);
+
+        // rows are about as long as the first one
+        auto chunkBegin = boundsData[chunk];
+        auto chunkEnd = boundsData[chunk + 1];
+        auto estimatedRows = (chunkEnd - chunkBegin) / lineSize + 1;
+        for (auto& column : chunkColumn)
+            column.reserve(estimatedRows);
+
+        DataStreamParser::parseCSVLines(chunkBegin, chunkEnd, delimiter,
+                                        chunkColumn, true,
+                                        invalidFieldsData[chunk]);
+    };
+
+    {
+        std::vector<std::jthread> workers;
+        for (qsizetype chunk = 1; chunk < chunkCount; ++chunk)
+            workers.emplace_back(parseChunk, chunk);
+        parseChunk(0);
+    }
+
+    qsizetype rows = 0;
+    for (auto& chunkColumn : chunkColumns)
+        rows += chunkColumn[0].size();
+    if (rows == 0)
+        return false;
+
+    columns.resize(columnCount);
+    for (qsizetype column = 0; column < columnCount; ++column) {
+        columns[column].reserve(rows);
+        for (auto& chunkColumn : chunkColumns) {
+            columns[column].append(chunkColumn[column]);
+            chunkColumn[column] = {};
+        }
+    }
+
+    auto totalInvalidFields =
+        std::accumulate(invalidFields.cbegin(), invalidFields.cend(),
+                        qsizetype{0});
+    if (totalInvalidFields != 0)
+        emit error(QString{"%1 invalid fields in %2 were read as NaN"}
+                       .arg(totalInvalidFields)
+                       .arg(path));
+
+    return true;
+}
+
+void CSVFileDataSource::sortByX(QVector<QVector<double>>& columns) {
+    const auto& x = columns[0];
+
+    // NaN x sorts last so the order stays strict weak
+    auto isLess = [&x](qsizetype a, qsizetype b) {
+        return x[a] < x[b] || (std::isnan(x[b]) && !std::isnan(x[a]));
+    };
+    auto isSorted = [&]() {
+        for (qsizetype i = 1; i < x.size(); ++i)
+            if (isLess(i, i - 1))
+                return false;
+        return true;
+    };
+    if (isSorted())
+        return;
+
+    QVector<qsizetype> order(x.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), isLess);
+
+    for (auto& column : columns) {
+        QVector<double> sorted(column.size());
+        for (qsizetype i = 0; i < order.size(); ++i)
+            sorted[i] = column[order[i]];
+        column = std::move(sorted);
+    }
+}
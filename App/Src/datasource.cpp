@@ -9,6 +9,9 @@
  */
 #include "datasource.h"
 
+#include <QThread>
+#include <utility>
+
 DataSource::DataSource(QObject* parent) : uuid{}, QObject{parent} {
     uuid.append(QUuid::createUuid());
 
@@ -17,8 +20,9 @@ DataSource::DataSource(QObject* parent) : uuid{}, QObject{parent} {
     connect(updateTimer, &QTimer::timeout, this, &DataSource::updateData);
     updateTimer->start();
 
-    dataX.append(QVector<double>{});
-    dataY.append(QVector<double>{});
+    pending.append(std::make_shared<SampleBlock>(0));
+    isResetPending.append(false);
+    heldBack.append(SampleBlock{0});
 
     connect(this, &DataSource::controlWordReceived, this,
             &DataSource::onControlWordReceived);
@@ -97,15 +101,39 @@ QPair<DataSource::DataControlWords, QByteArray> DataSource::parseControlWord(
     }
 }
 
-void DataSource::clearAllData() {
-    for (auto& xArr : dataX) {
-        xArr.clear();
+std::shared_ptr<SampleStream> DataSource::subscribe(DSID id,
+                                                    std::size_t capacity) {
+    qsizetype index;
+    {
+        QMutexLocker locker{&uuidMutex};
+        index = uuid.indexOf(id);
     }
-    for (auto& yArr : dataY) {
-        yArr.clear();
+    if (index < 0)
+        return nullptr;
+
+    auto stream = std::make_shared<SampleStream>(capacity, dropPolicy.load());
+
+    QMutexLocker locker{&streamMutex};
+    streams[index].append(stream);
+    return stream;
+}
+
+void DataSource::setDropPolicy(DropPolicy policy) {
+    dropPolicy = policy;
+
+    QMutexLocker locker{&streamMutex};
+    for (auto& channelStreams : streams) {
+        for (auto& stream : channelStreams) {
+            stream->setDropPolicy(policy);
+        }
     }
 }
 
+void DataSource::clearAllData() {
+    clearQueuedData();
+    isResetPending.fill(true);
+}
+
 void DataSource::onControlWordReceived(qsizetype index, DataControlWords words,
                                        QByteArray data) {
     switch (words) {
@@ -116,13 +144,9 @@ void DataSource::onControlWordReceived(qsizetype index, DataControlWords words,
         case DataControlWords::SlelectSubplot: {
             currentSelectedChannel = data.toLongLong();
 
-            if (dataX.size() <= currentSelectedChannel) {
-                dataX.append(QVector<double>{});
-                dataY.append(QVector<double>{});
-
-                uuid.append(QUuid::createUuid());
-                emit newDataChannelCreated(currentSelectedChannel,
-                                           uuid.constLast());
+            while (pending.size() <= currentSelectedChannel) {
+                auto index = createChannel();
+                emit newDataChannelCreated(index, getId(index));
             }
         } break;
 
@@ -131,31 +155,114 @@ void DataSource::onControlWordReceived(qsizetype index, DataControlWords words,
     }
 }
 
-void DataSource::appendData(QVector<double> x, QVector<double> y) {
-    dataX[currentSelectedChannel].append(x);
-    dataY[currentSelectedChannel].append(y);
+void DataSource::appendData(qsizetype index,
+                            std::shared_ptr<SampleBlock> block) {
+    if (pending[index]->isEmpty()) {
+        pending[index] = std::move(block);
+        return;
+    }
+
+    pending[index]->append(*block);
+}
+
+void DataSource::replaceData(qsizetype index,
+                             std::shared_ptr<SampleBlock> block) {
+    pending[index] = std::move(block);
+    isResetPending[index] = true;
+}
+
+SampleBlock& DataSource::channelBuffer(qsizetype index) {
+    return *pending[index];
+}
+
+qsizetype DataSource::createChannel() {
+    heldBack.append(SampleBlock{pending.size()});
+    pending.append(std::make_shared<SampleBlock>(pending.size()));
+    isResetPending.append(false);
+
+    QMutexLocker locker{&uuidMutex};
+    uuid.append(QUuid::createUuid());
+
+    return uuid.size() - 1;
 }
 
 void DataSource::clearQueuedData() {
-    for (auto& xArr : dataX) {
-        xArr.clear();
+    for (auto& block : pending) {
+        block->clear();
     }
-    for (auto& yArr : dataY) {
-        yArr.clear();
+    for (auto& block : heldBack) {
+        block.clear();
     }
 }
 
 void DataSource::updateData() {
-    if (dataX.isEmpty())
+    if (pending.isEmpty())
         return;
 
-    for (auto i = 0; i < dataX.size(); ++i) {
-        if (dataX[i].isEmpty())
+    for (auto i = 0; i < pending.size(); ++i) {
+        if (pending[i]->isEmpty() && !isResetPending[i] &&
+            heldBack[i].isEmpty())
+            continue;
+
+        // copied out, a blocking write must not hold the lock a consumer
+        // subscribes with
+        QVector<std::shared_ptr<SampleStream>> channelStreams;
+        {
+            QMutexLocker locker{&streamMutex};
+            auto it = streams.find(i);
+            if (it != streams.end()) {
+                // released by their consumer
+                it->removeIf(
+                    [](auto& stream) { return stream.use_count() == 1; });
+                channelStreams = *it;
+            }
+        }
+
+        // published as is, the producer continues in a fresh block with the
+        // capacity of the last one instead of regrowing
+        auto batchSize = pending[i]->size();
+        SampleBlockPtr block =
+            std::exchange(pending[i], std::make_shared<SampleBlock>(i));
+        pending[i]->reserve(batchSize);
+
+        // derived sources get every batch at once, whether or not the
+        // channel has a plot
+        if (!block->isEmpty())
+            emit dataReceived(i, block);
+
+        if (channelStreams.isEmpty()) {
+            // e.g. a channel just created by %SUBPLOT whose plot subscribes
+            // later, its samples are held back until then
+            if (isResetPending[i])
+                heldBack[i].clear();
+            heldBack[i].append(*block);
+            heldBack[i].removeFirst(heldBack[i].size() -
+                                    qsizetype(SampleStream::defaultCapacity));
+
+            isResetPending[i] = false;
             continue;
+        }
+
+        // shared by the first streams of the channel like any other block
+        SampleBlockPtr held;
+        if (!heldBack[i].isEmpty() && !isResetPending[i])
+            held = std::make_shared<SampleBlock>(std::move(heldBack[i]));
+        heldBack[i] = SampleBlock{i};
 
-        emit dataReceived(i, dataX[i], dataY[i]);
+        for (auto& stream : channelStreams) {
+            if (isResetPending[i])
+                stream->reset();
+
+            // held by streams, channelStreams and the consumer
+            auto isCanceled = [this, &stream]() {
+                return isTerminateSerial || stream.use_count() <= 2 ||
+                       QThread::currentThread()->isInterruptionRequested();
+            };
+            if (held != nullptr)
+                stream->write(held, isCanceled);
+            stream->write(block, isCanceled);
+        }
 
-        dataX[i].clear();
-        dataY[i].clear();
+        isResetPending[i] = false;
     }
 }
@@ -7,23 +7,114 @@
  * @copyright Copyright (c) nmpassthf 2023
  *
  */
-#include "dataStreamParser.h"
+#include "datastreamparser.h"
 
-#include <ranges>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "tokenscanner.hpp"
+
+/**
+ * @brief load a little endian T from unaligned memory
+ */
+template <typename T>
+static inline T loadLittleEndian(const uint8_t* p) {
+    using Bits = std::conditional_t<
+        sizeof(T) == 2, uint16_t,
+        std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>;
+
+    Bits bits;
+    std::memcpy(&bits, p, sizeof(T));
+    if constexpr (std::endian::native == std::endian::big)
+        bits = std::byteswap(bits);
+    return std::bit_cast<T>(bits);
+}
+
+template <typename T>
+static void decodeSamples(const uint8_t* payload, qsizetype count,
+                          double* out) {
+    for (qsizetype i = 0; i < count; ++i)
+        out[i] = static_cast<double>(
+            loadLittleEndian<T>(payload + i * sizeof(T)));
+}
+
+/**
+ * @brief CRC-16/CCITT-FALSE, poly 0x1021, init 0xffff
+ */
+static uint16_t crc16(const uint8_t* data, qsizetype size) {
+    constexpr static auto table = []() {
+        std::array<uint16_t, 256> table{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint16_t crc = i << 8;
+            for (int bit = 0; bit < 8; ++bit)
+                crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+            table[i] = crc;
+        }
+        return table;
+    }();
+
+    uint16_t crc = 0xffff;
+    for (qsizetype i = 0; i < size; ++i)
+        crc = (crc << 8) ^ table[(crc >> 8) ^ data[i]];
+    return crc;
+}
 
 DataStreamParser::DataStreamParser(SourceType type) : type{type} {
     x.append(0);
     step.append(0);
 }
 
+bool DataStreamParser::seekStartFlag() {
+    constexpr QByteArrayView startFlag{"%START"};
+
+    auto data = unparsedData();
+    auto index = data.indexOf(startFlag);
+    if (index < 0) {
+        // keep what may be the beginning of a split flag
+        dropData(std::max<qsizetype>(data.size() - (startFlag.size() - 1), 0));
+        return false;
+    }
+
+    // %START itself is parsed as the first control word
+    dropData(index);
+    return true;
+}
+
+void DataStreamParser::selectChannel(qsizetype index) {
+    currentSelectIndex = index;
+
+    while (currentSelectIndex >= step.size()) {
+        step.append(1.0);
+        x.append(0.0);
+    }
+}
+
+void DataStreamParser::resetChannels() {
+    x.clear();
+    x.append(0.0);
+
+    step.clear();
+    step.append(1.0);
+
+    currentSelectIndex = 0;
+}
+
 std::optional<QPair<DataStreamParser::RDataType, QVariant>>
-DataStreamParser::parseData() {
+DataStreamParser::parseData(SampleBlock& block) {
     switch (type) {
         case SourceType::StringStream:
-            return parseAsStringStream();
+            return parseAsStringStream(block);
             break;
         case SourceType::CSV_File:
-            return parseAsCSVFile();
+            return parseAsCSVFile(block);
+            break;
+        case SourceType::BinaryFrame:
+            return parseAsBinaryFrame(block);
             break;
 
         default:
@@ -33,143 +124,360 @@ DataStreamParser::parseData() {
     return std::nullopt;
 }
 
+bool DataStreamParser::continueBlock(SampleBlock& block) {
+    const auto currentX = x[currentSelectIndex];
+    const auto currentStep = step[currentSelectIndex];
+
+    if (block.isEmpty())
+        block.setUniform(currentX, currentStep);
+    else if (!block.isContinuedBy(currentX, currentStep))
+        block.materializeX();
+
+    return block.isUniform();
+}
+
 std::optional<QPair<DataStreamParser::RDataType, QVariant>>
-DataStreamParser::parseAsStringStream() {
-    using namespace std::ranges;
-    using namespace std;
-
-    enum State {
-        NumPrefix,
-        Num,
-        NumInterfix,
-        Cmd,
-        Gap,
-        Begin
-    } state = State::Begin;
-
-    QByteArray wordBuffer{};
-    wordBuffer.reserve(maxWordSize);
-
-    for (const auto& [c, i] : zip_view(buffer, views::iota(0, buffer.size()))) {
-        auto makeErrorString = [&](auto errLocateStr) {
-            return QString(
-                       "Error: Invalid char %1(0x%2) in %3. \nraw "
-                       "data:\n%4\n\tat ->%5\n")
-                .arg(c)
-                .arg((uint8_t)c, 0, 16)
-                .arg(errLocateStr)
-                .arg(buffer)
-                .arg(i);
-        };
-        auto removeBufferFront = [&]() { buffer.remove(0, i + 1); };
-
-        switch (state) {
-            case State::NumPrefix:
-                if (isNumberChar(c)) {
-                    state = State::Num;
-                    wordBuffer.append(c);
-                } else {
-                    buffer.clear();
-                    return qMakePair(
-                        RDataType::RDataErrorString,
-                        makeErrorString("number prefix is end with non-number "
-                                        "char or number interfix char"));
-                }
-                break;
-            case State::Num:
-                if (isGapChar(c)) {
-                    bool ok = false;
-                    qreal rYVal = wordBuffer.toDouble(&ok);
-                    if (!ok) {
-                        buffer.clear();
-                        return qMakePair(
-                            RDataType::RDataErrorString,
-                            makeErrorString("number is not valid"));
-                    }
-
-                    auto rVal = QVariant::fromValue(QPointF{x[currentSelectIndex], rYVal});
-                    x[currentSelectIndex] += step[currentSelectIndex];
-                    removeBufferFront();
-                    return qMakePair(RDataType::RDataPointF, rVal);
-                } else if (isNumberChar(c)) {
-                    wordBuffer.append(c);
-                } else if (isNumberInterfixChar(c)) {
-                    state = State::NumInterfix;
-                    wordBuffer.append(c);
-                } else {
-                    buffer.clear();
-                    return qMakePair(
-                        RDataType::RDataErrorString,
-                        makeErrorString("number is end with non-number char"));
-                }
-                break;
-            case State::NumInterfix:
-                if (isNumberChar(c)) {
-                    state = State::Num;
-                    wordBuffer.append(c);
-                } else if (isNumberPrefixChar(c)) {
-                    wordBuffer.append(c);
-                    state = State::NumPrefix;
-                } else {
-                    buffer.clear();
-                    return qMakePair(
-                        RDataType::RDataErrorString,
-                        makeErrorString("number interfix is end with "
-                                        "non-number char"));
-                };
-            case State::Cmd:
-                if (c != '%') {
-                    wordBuffer.append(c);
-                } else {
-                    wordBuffer.append(c);
-                    removeBufferFront();
-                    return qMakePair(RDataType::RDataControlWord, wordBuffer);
-                }
-                break;
-            case State::Gap:
-                if (isGapChar(c)) {
-                    // do nothing
-                } else if (c == '%') {
-                    state = State::Cmd;
-                    wordBuffer.append(c);
-                } else if (isNumberPrefixChar(c)) {
-                    state = State::NumPrefix;
-                    wordBuffer.append(c);
-                } else if (isNumberChar(c)) {
-                    state = State::Num;
-                    wordBuffer.append(c);
-                } else {
-                    buffer.clear();
-                    return qMakePair(RDataType::RDataErrorString,
-                                     makeErrorString("gap"));
-                }
-                break;
-            case State::Begin:
-                if (isGapChar(c)) {
-                    state = State::Gap;
-                } else if (c == '%') {
-                    state = State::Cmd;
-                    wordBuffer.append(c);
-                } else if (isNumberPrefixChar(c)) {
-                    state = State::NumPrefix;
-                    wordBuffer.append(c);
-                } else if (isNumberChar(c)) {
-                    state = State::Num;
-                    wordBuffer.append(c);
-                } else {
-                    buffer.clear();
-                    return qMakePair(RDataType::RDataErrorString,
-                                     makeErrorString("begin"));
-                }
+DataStreamParser::parseAsStringStream(SampleBlock& block) {
+    const char* const begin = buffer.data();
+    const char* const end = begin + buffer.size();
+    const char* cursor = begin;
+    TokenScanner scanner{begin, end};
+
+    auto makeErrorString = [&](const char* errPos, auto errLocateStr) {
+        return QString(
+                   "Error: Invalid char %1(0x%2) in %3. \nraw "
+                   "data:\n%4\n\tat ->%5\n")
+            .arg(*errPos)
+            .arg((uint8_t)*errPos, 0, 16)
+            .arg(errLocateStr)
+            .arg(QString::fromUtf8(begin, end - begin))
+            .arg(errPos - begin);
+    };
+    auto makeError = [&](const char* errPos, auto errLocateStr) {
+        auto errorString = makeErrorString(errPos, errLocateStr);
+        buffer.clear();
+        return qMakePair(RDataType::RDataErrorString, QVariant{errorString});
+    };
+
+    auto& currentX = x[currentSelectIndex];
+    const auto currentStep = step[currentSelectIndex];
+    const bool isUniform = continueBlock(block);
+
+    while ((cursor = scanner.skipGaps(cursor)) != end) {
+        auto wordBegin = cursor;
+
+        // control word, %...%
+        if (*cursor == '%') {
+            auto wordEnd = scanner.findPercent(cursor + 1);
+            if (wordEnd == end)
                 break;
+
+            QByteArray controlWord{wordBegin, wordEnd + 1 - wordBegin};
+            buffer.consume(wordEnd + 1 - begin);
+            return qMakePair(RDataType::RDataControlWord,
+                             QVariant{controlWord});
         }
+
+        // number, ends with a gap char
+        auto wordEnd = scanner.findGap(cursor);
+        if (wordEnd == end)
+            break;
+
+        auto numberBegin = wordBegin + isNumberPrefixChar(*wordBegin);
+        if (numberBegin == wordEnd || !isNumberChar(*numberBegin))
+            return makeError(numberBegin == wordEnd ? wordBegin : numberBegin,
+                             "number prefix is end with non-number char");
+
+        // from_chars doesn't take a leading '+'
+        double yVal;
+        auto [numberEnd, ec] = std::from_chars(
+            *wordBegin == '+' ? numberBegin : wordBegin, wordEnd, yVal);
+        if (ec != std::errc{})
+            return makeError(wordBegin, "number is not valid");
+        if (numberEnd != wordEnd)
+            return makeError(numberEnd, "number is end with non-number char");
+
+        if (isUniform)
+            block.append(yVal);
+        else
+            block.append(currentX, yVal);
+        currentX += currentStep;
+
+        cursor = wordEnd + 1;
     }
 
+    // keep the incomplete word for the next call
+    buffer.consume(cursor - begin);
     return std::nullopt;
 }
 
 std::optional<QPair<DataStreamParser::RDataType, QVariant>>
-DataStreamParser::parseAsCSVFile() {
-    // TODO Support CSV file
+DataStreamParser::parseAsCSVFile(SampleBlock& block) {
+    const char* const begin = buffer.data();
+    const char* const end = begin + buffer.size();
+    const char* cursor = begin;
+
+    // the first non empty line decides the layout and may be a header
+    while (csvColumnCount == 0) {
+        auto lineEnd = std::find(cursor, end, '\n');
+        if (lineEnd == end) {
+            buffer.consume(cursor - begin);
+            return std::nullopt;
+        }
+
+        csvDelimiter = detectCSVDelimiter(cursor, lineEnd);
+        csvColumnCount = countCSVFields(cursor, lineEnd, csvDelimiter);
+        if (csvColumnCount != 0 && !isCSVHeader(cursor, lineEnd, csvDelimiter))
+            break;
+
+        cursor = lineEnd + 1;
+    }
+
+    // "x, y, ..." lines, or "y" lines with x from the channel step
+    QVector<QVector<double>> columns(std::min<qsizetype>(csvColumnCount, 2));
+    qsizetype invalidFields = 0;
+    cursor = parseCSVLines(cursor, end, csvDelimiter, columns, false,
+                           invalidFields);
+    buffer.consume(cursor - begin);
+
+    if (columns.size() == 2) {
+        block.append(columns[0].constData(), columns[1].constData(),
+                     columns[0].size());
+    } else if (!columns[0].isEmpty()) {
+        auto& currentX = x[currentSelectIndex];
+        const auto currentStep = step[currentSelectIndex];
+        if (continueBlock(block)) {
+            std::copy(columns[0].cbegin(), columns[0].cend(),
+                      block.appendY(columns[0].size()));
+            currentX += currentStep * columns[0].size();
+        } else {
+            for (auto value : columns[0]) {
+                block.append(currentX, value);
+                currentX += currentStep;
+            }
+        }
+    }
+
+    if (invalidFields != 0)
+        return qMakePair(
+            RDataType::RDataErrorString,
+            QVariant{QString("Error: %1 invalid fields in CSV stream were "
+                             "read as NaN\n")
+                         .arg(invalidFields)});
+
     return std::nullopt;
 }
+
+static inline bool isCSVBlank(char c) { return c == ' ' || c == '\t'; }
+
+char DataStreamParser::detectCSVDelimiter(const char* lineBegin,
+                                          const char* lineEnd) {
+    char delimiter = ' ';
+    qsizetype maxCount = 0;
+    for (auto candidate : {',', '\t', ';'}) {
+        auto count = std::count(lineBegin, lineEnd, candidate);
+        if (count > maxCount) {
+            delimiter = candidate;
+            maxCount = count;
+        }
+    }
+    return delimiter;
+}
+
+qsizetype DataStreamParser::countCSVFields(const char* lineBegin,
+                                           const char* lineEnd,
+                                           char delimiter) {
+    auto p = std::find_if_not(lineBegin, lineEnd, isCSVBlank);
+    if (p == lineEnd || *p == '#' || *p == '\r')
+        return 0;
+
+    if (delimiter != ' ')
+        return std::count(p, lineEnd, delimiter) + 1;
+
+    qsizetype count = 0;
+    while (p != lineEnd && *p != '\r') {
+        ++count;
+        p = std::find_if(p, lineEnd, isCSVBlank);
+        p = std::find_if_not(p, lineEnd, isCSVBlank);
+    }
+    return count;
+}
+
+bool DataStreamParser::isCSVHeader(const char* lineBegin, const char* lineEnd,
+                                   char delimiter) {
+    QVector<QVector<double>> firstColumn(1);
+    qsizetype invalidFields = 0;
+    parseCSVLines(lineBegin, lineEnd, delimiter, firstColumn, true,
+                  invalidFields);
+    return invalidFields != 0;
+}
+
+const char* DataStreamParser::parseCSVLines(const char* begin, const char* end,
+                                            char delimiter,
+                                            QVector<QVector<double>>& columns,
+                                            bool isEndOfData,
+                                            qsizetype& invalidFields) {
+    constexpr auto nan = std::numeric_limits<double>::quiet_NaN();
+    const bool isBlankDelimited = delimiter == ' ';
+
+    auto lineBegin = begin;
+    while (lineBegin != end) {
+        auto lineEnd = std::find(lineBegin, end, '\n');
+        if (lineEnd == end && !isEndOfData)
+            break;
+        auto next = lineEnd == end ? end : lineEnd + 1;
+
+        if (lineEnd != lineBegin && lineEnd[-1] == '\r')
+            --lineEnd;
+
+        auto p = std::find_if_not(lineBegin, lineEnd, isCSVBlank);
+        if (p == lineEnd || *p == '#') {
+            lineBegin = next;
+            continue;
+        }
+
+        for (auto& column : columns) {
+            auto fieldEnd = isBlankDelimited
+                                ? std::find_if(p, lineEnd, isCSVBlank)
+                                : std::find(p, lineEnd, delimiter);
+
+            // trim blanks around the field
+            auto fieldBegin = std::find_if_not(p, fieldEnd, isCSVBlank);
+            auto valueEnd = fieldEnd;
+            while (valueEnd != fieldBegin && isCSVBlank(valueEnd[-1]))
+                --valueEnd;
+
+            double value = nan;
+            if (fieldBegin != valueEnd) {
+                // from_chars doesn't take a leading '+'
+                if (*fieldBegin == '+')
+                    ++fieldBegin;
+                auto [numberEnd, ec] =
+                    std::from_chars(fieldBegin, valueEnd, value);
+                if (ec != std::errc{} || numberEnd != valueEnd) {
+                    value = nan;
+                    ++invalidFields;
+                }
+            }
+            column.append(value);
+
+            p = fieldEnd == lineEnd ? lineEnd : fieldEnd + 1;
+            if (isBlankDelimited)
+                p = std::find_if_not(p, lineEnd, isCSVBlank);
+        }
+
+        lineBegin = next;
+    }
+
+    return lineBegin;
+}
+
+std::optional<QPair<DataStreamParser::RDataType, QVariant>>
+DataStreamParser::parseAsBinaryFrame(SampleBlock& block) {
+    const auto* const begin =
+        reinterpret_cast<const uint8_t*>(buffer.data());
+    const auto* const end = begin + buffer.size();
+    const auto* cursor = begin;
+    std::optional<QPair<RDataType, QVariant>> result = std::nullopt;
+
+    constexpr uint8_t syncLow = frameSyncWord & 0xff;
+    constexpr uint8_t syncHigh = frameSyncWord >> 8;
+
+    while (end - cursor >= frameHeaderSize) {
+        if (cursor[0] != syncLow || cursor[1] != syncHigh) {
+            cursor = std::find(cursor + 1, end, syncLow);
+            continue;
+        }
+
+        const auto channel = cursor[2];
+        const auto flags = cursor[3];
+        const auto sampleType = SampleType(flags & frameSampleTypeMask);
+        const auto count = qsizetype(loadLittleEndian<uint16_t>(cursor + 4));
+        const auto sampleSize = sampleTypeSize(sampleType);
+        const bool hasCRC = flags & frameHasCRCFlag;
+
+        // not a frame header, the sync word was part of the payload or noise
+        if (sampleSize == 0 || count == 0 || count > maxFrameSamples) {
+            ++cursor;
+            continue;
+        }
+
+        const auto payloadSize = count * sampleSize;
+        const auto frameSize =
+            frameHeaderSize + payloadSize + (hasCRC ? frameCRCSize : 0);
+        if (end - cursor < frameSize)
+            break;
+
+        const auto* payload = cursor + frameHeaderSize;
+        if (hasCRC && crc16(cursor + 2, frameHeaderSize - 2 + payloadSize) !=
+                          loadLittleEndian<uint16_t>(payload + payloadSize)) {
+            result = qMakePair(
+                RDataType::RDataErrorString,
+                QVariant{QString("Error: CRC mismatch in binary frame of "
+                                 "channel %1, resyncing\n")
+                             .arg(channel)});
+            ++cursor;
+            break;
+        }
+
+        if (sampleType == SampleType::ControlWord) {
+            result = qMakePair(
+                RDataType::RDataControlWord,
+                QVariant{QByteArray{reinterpret_cast<const char*>(payload),
+                                    payloadSize}});
+            cursor += frameSize;
+            break;
+        }
+
+        if (channel != currentSelectIndex) {
+            // decoded by the next call, once the owner switched channel
+            result = qMakePair(
+                RDataType::RDataControlWord,
+                QVariant{"%SUBPLOT " + QByteArray::number(channel) + '%'});
+            break;
+        }
+
+        // y is decoded in place, x is only written if the block stores it
+        auto& currentX = x[currentSelectIndex];
+        const auto currentStep = step[currentSelectIndex];
+        const bool isUniform = continueBlock(block);
+        if (!isUniform)
+            decodeBuffer.resize(count);
+
+        auto* y = isUniform ? block.appendY(count) : decodeBuffer.data();
+        switch (sampleType) {
+            case SampleType::Int16:
+                decodeSamples<int16_t>(payload, count, y);
+                break;
+            case SampleType::UInt16:
+                decodeSamples<uint16_t>(payload, count, y);
+                break;
+            case SampleType::Int32:
+                decodeSamples<int32_t>(payload, count, y);
+                break;
+            case SampleType::Float32:
+                decodeSamples<float>(payload, count, y);
+                break;
+            case SampleType::Float64:
+                decodeSamples<double>(payload, count, y);
+                break;
+            default:
+                break;
+        }
+
+        if (isUniform) {
+            currentX += currentStep * count;
+        } else {
+            for (qsizetype i = 0; i < count; ++i) {
+                block.append(currentX, y[i]);
+                currentX += currentStep;
+            }
+        }
+
+        cursor += frameSize;
+    }
+
+    // keep the incomplete frame for the next call
+    buffer.consume(cursor - begin);
+    return result;
+}
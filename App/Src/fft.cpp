@@ -10,37 +10,137 @@
 #include <pch.h>
 #include "fft.hpp"
 
+#include <bit>
+#include <map>
+#include <memory>
+#include <stdexcept>
+
 constexpr double __BBR_FFT_PI = 3.14159265358979323846;
 
-ComplexArray Fourier::fft(const ComplexArray& inputData) {
-    if (inputData.empty())
-        return {};
+FFTPlan::FFTPlan(std::size_t size) : n{size} {
+    if (n == 0)
+        return;
+
+    if (!std::has_single_bit(n))
+        throw std::invalid_argument{"FFTPlan: size must be a power of two"};
+
+    twiddles.resize(n / 2);
+    for (std::size_t k = 0; k < n / 2; ++k) {
+        twiddles[k] = std::polar(1.0, -2 * __BBR_FFT_PI * k / n);
+    }
+
+    auto bits = std::countr_zero(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        std::size_t j = 0;
+        for (auto b = 0; b < bits; ++b) {
+            j |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+
+        if (i < j)
+            bitReverseSwaps.push_back(
+                {static_cast<uint32_t>(i), static_cast<uint32_t>(j)});
+    }
+}
+
+void FFTPlan::forward(ComplexDouble* data) const { transform<false>(data); }
+
+void FFTPlan::inverse(ComplexDouble* data) const { transform<true>(data); }
+
+template <bool isInverse>
+void FFTPlan::transform(ComplexDouble* data) const {
+    if (n < 2)
+        return;
 
-    auto n{inputData.size()};
+    for (const auto& [i, j] : bitReverseSwaps) {
+        std::swap(data[i], data[j]);
+    }
+
+    // first stage, every twiddle is 1
+    for (std::size_t i = 0; i < n; i += 2) {
+        auto u = data[i];
+        auto v = data[i + 1];
+        data[i] = u + v;
+        data[i + 1] = u - v;
+    }
+
+    for (std::size_t len = 4; len <= n; len <<= 1) {
+        auto half = len / 2;
+        auto stride = n / len;
+
+        for (std::size_t i = 0; i < n; i += len) {
+            auto* lo = data + i;
+            auto* hi = lo + half;
+
+            for (std::size_t j = 0; j < half; ++j) {
+                auto w = twiddles[j * stride];
+                if constexpr (isInverse)
+                    w = std::conj(w);
+
+                auto v = hi[j] * w;
+                hi[j] = lo[j] - v;
+                lo[j] += v;
+            }
+        }
+    }
+}
+
+RealFFTPlan::RealFFTPlan(std::size_t size) : n{size} {
+    if (n == 0)
+        return;
+
+    if (n < 2 || !std::has_single_bit(n))
+        throw std::invalid_argument{
+            "RealFFTPlan: size must be a power of two"};
 
-    // Handle the special case of a vector of size 1 (there's nothing to
-    // transform)
-    if (n == 1)
-        return inputData;
+    halfPlan = FFTPlan{n / 2};
 
-    // Divide the input vector into two halves
-    ComplexArray vec1(n / 2), vec2(n / 2);
-    for (int i = 0; i < n / 2; ++i) {
-        vec1[i] = inputData[i * 2];
-        vec2[i] = inputData[i * 2 + 1];
+    twiddles.resize(n / 4 + 1);
+    for (std::size_t k = 0; k <= n / 4; ++k) {
+        twiddles[k] = std::polar(1.0, -2 * __BBR_FFT_PI * k / n);
     }
+}
+
+void RealFFTPlan::forward(const double* input, ComplexDouble* output) const {
+    if (n == 0)
+        return;
 
-    // Recursively compute the FFT of each half
-    vec1 = fft(vec1);
-    vec2 = fft(vec2);
+    auto half = n / 2;
 
-    // Compute the FFT of the whole vector using the FFTs of the two halves
-    ComplexArray result(n);
-    for (int i = 0; i < n; ++i) {
-        ComplexDouble omega = exp(ComplexDouble(0, -2 * __BBR_FFT_PI * i / n));
-        result[i] = vec1[i % (n / 2)] + omega * vec2[i % (n / 2)];
+    // pack even samples as real part and odd samples as imag part
+    for (std::size_t m = 0; m < half; ++m) {
+        output[m] = {input[2 * m], input[2 * m + 1]};
     }
 
+    halfPlan.forward(output);
+
+    // untangle, X[k] = E[k] + W^k * O[k] with
+    // E[k] = (Z[k] + conj(Z[h-k])) / 2, O[k] = (Z[k] - conj(Z[h-k])) / 2i
+    auto z0 = output[0];
+    output[0] = {z0.real() + z0.imag(), 0};
+    output[half] = {z0.real() - z0.imag(), 0};
+
+    for (std::size_t k = 1; k <= half / 2; ++k) {
+        auto j = half - k;
+        auto a = output[k];
+        auto b = std::conj(output[j]);
+
+        auto even = (a + b) * 0.5;
+        auto odd = (a - b) * ComplexDouble{0, -0.5};
+
+        // W^j = -conj(W^k) since j = n/2 - k
+        auto w = twiddles[k];
+        output[k] = even + w * odd;
+        output[j] = std::conj(even) - std::conj(w) * std::conj(odd);
+    }
+}
+
+ComplexArray Fourier::fft(const ComplexArray& inputData) {
+    if (inputData.empty())
+        return {};
+
+    ComplexArray result = inputData;
+    plan(result.size()).forward(result.data());
+
     return result;
 }
 
@@ -48,29 +148,64 @@ ComplexArray Fourier::ifft(const ComplexArray& inputData) {
     if (inputData.empty())
         return {};
 
-    auto n{inputData.size()};
+    ComplexArray result = inputData;
+    plan(result.size()).inverse(result.data());
 
-    // Handle the special case of a vector of size 1 (there's nothing to
-    // transform)
-    if (n == 1)
-        return inputData;
+    return result;
+}
 
-    // Divide the input vector into two halves
-    ComplexArray vec1(n / 2), vec2(n / 2);
-    for (int i = 0; i < n / 2; ++i) {
-        vec1[i] = inputData[i * 2];
-        vec2[i] = inputData[i * 2 + 1];
-    }
+ComplexArray Fourier::rfft(const std::vector<double>& inputData) {
+    if (inputData.empty())
+        return {};
+
+    ComplexArray result(inputData.size() / 2 + 1);
+    realPlan(inputData.size()).forward(inputData.data(), result.data());
+
+    return result;
+}
+
+const FFTPlan& Fourier::plan(std::size_t size) {
+    thread_local std::map<std::size_t, std::unique_ptr<FFTPlan>> plans;
 
-    // Recursively compute the IFFT of each half
-    vec1 = ifft(vec1);
-    vec2 = ifft(vec2);
+    auto& cached = plans[size];
+    if (cached == nullptr)
+        cached = std::make_unique<FFTPlan>(size);
+
+    return *cached;
+}
+
+const RealFFTPlan& Fourier::realPlan(std::size_t size) {
+    thread_local std::map<std::size_t, std::unique_ptr<RealFFTPlan>> plans;
+
+    auto& cached = plans[size];
+    if (cached == nullptr)
+        cached = std::make_unique<RealFFTPlan>(size);
+
+    return *cached;
+}
 
-    // Compute the IFFT of the whole vector using the IFFTs of the two halves
-    ComplexArray result(n);
-    for (int i = 0; i < n; ++i) {
-        ComplexDouble omega = exp(ComplexDouble(0, 2 * __BBR_FFT_PI * i / n));
-        result[i] = vec1[i % (n / 2)] + omega * vec2[i % (n / 2)];
+std::vector<double> Fourier::window(WindowFunction function,
+                                    std::size_t size) {
+    std::vector<double> result(size, 1.0);
+
+    for (std::size_t i = 0; i < size; ++i) {
+        auto phase = 2 * __BBR_FFT_PI * i / size;
+
+        switch (function) {
+            case Hann:
+                result[i] = 0.5 - 0.5 * std::cos(phase);
+                break;
+            case Hamming:
+                result[i] = 0.54 - 0.46 * std::cos(phase);
+                break;
+            case Blackman:
+                result[i] = 0.42 - 0.5 * std::cos(phase) +
+                            0.08 * std::cos(2 * phase);
+                break;
+            case Rectangular:
+            default:
+                break;
+        }
     }
 
     return result;
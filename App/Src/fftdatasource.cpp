@@ -9,36 +9,46 @@
  */
 #include "fftdatasource.h"
 
-#include <QApplication>
 #include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <bit>
+#include <numeric>
 #include <ranges>
 
-FFTDataSource::FFTDataSource(FFTWorkMode mode,
-                             DataSource const* otherRegularSource,
-                             QObject* parent)
-    : workMode{mode}, DataSource{parent} {
-    dataset.reserve(fftSize);
+FFTDataSource::FFTDataSource(DataSource const* otherRegularSource,
+                             qsizetype sourceChannel, QObject* parent)
+    : sourceChannel{sourceChannel}, DataSource{parent} {
+    // channel 0 (Amplitude) is created by DataSource
+    for (auto output = 1; output < SpectrumOutputCount; ++output) {
+        createChannel();
+    }
+
+    frame.resize(fftSize);
+    spectrum.resize(fftSize / 2 + 1);
+    window = Fourier::window(windowFunction, fftSize);
+    windowGain = std::accumulate(window.cbegin(), window.cend(), 0.0);
+    resetAveraging();
 
     connect(otherRegularSource, &DataSource::dataReceived, this,
-            [this](qsizetype index, QVector<double> xs, QVector<double> ys) {
-                if (index != currentSelectedChannel)
+            [this](qsizetype index, SampleBlockPtr block) {
+                if (index != this->sourceChannel)
                     return;
 
-                for (auto& y : ys) {
-                    if (dataset.size() < fftSize)
-                        dataset.push_back({y, 0});
-                    else {
-                        dataset.erase(dataset.begin());
-                        dataset.push_back({y, 0});
-                    }
-                    isDataUpdated = true;
-                }
+                if (block->isEmpty())
+                    return;
+
+                // a uniform block carries the step itself
+                if (block->isUniform() && block->dt() != 0)
+                    step = block->dt();
+
+                appendSamples(block->y(), block->size());
             });
 
     connect(otherRegularSource, &DataSource::controlWordReceived, this,
             [this](qsizetype index, DataSource::DataControlWords c,
                    QByteArray DCWData) {
-                if (index != currentSelectedChannel)
+                if (index != this->sourceChannel)
                     return;
 
                 if (c == DataSource::DataControlWords::SetXAxisStep) {
@@ -50,78 +60,250 @@ FFTDataSource::FFTDataSource(FFTWorkMode mode,
 FFTDataSource::~FFTDataSource() {}
 
 void FFTDataSource::run() {
-    while (!isTerminateSerial) {
-        QApplication::processEvents();
+    // everything else is driven by the event loop of this thread
+    frameTimer = new QTimer{this};
+    frameTimer->setSingleShot(true);
+    connect(frameTimer, &QTimer::timeout, this, &FFTDataSource::processFrame);
 
-        if (!isDataUpdated) {
-            continue;
-        }
+    if (isDataUpdated)
+        scheduleFrame();
+}
 
-        // detect is steo us undefined
-        if (step == 0) {
-            emit controlWordReceived(currentSelectedChannel,
-                                     DataControlWords::SetXAxisStep,
-                                     QByteArray::number(1));
-            emit error("FFTDataSource: step is undefined, reset to 1");
-        }
+void FFTDataSource::requestStopDataSource() {
+    DataSource::requestStopDataSource();
+
+    if (frameTimer != nullptr)
+        frameTimer->stop();
+
+    emit finished();
+}
+
+void FFTDataSource::scheduleFrame() {
+    if (frameTimer == nullptr || isTerminateSerial || frameTimer->isActive())
+        return;
+
+    auto frameInterval = 1000 / frameRate;
+    auto elapsed = lastFrameTime.isValid() ? lastFrameTime.elapsed()
+                                           : qint64{frameInterval};
+
+    frameTimer->start(std::max<qint64>(0, frameInterval - elapsed));
+}
+
+void FFTDataSource::appendSamples(const double* samples, qsizetype count) {
+    if (averagingMode == NoAveraging) {
+        dataset.push(samples, count);
+        isDataUpdated = true;
+        scheduleFrame();
+        return;
+    }
+
+    // feed the window hop by hop, every completed hop of a full window is
+    // one new segment
+    while (count > 0) {
+        auto n = std::min<qsizetype>(count, hopSize - samplesSinceHop);
+        dataset.push(samples, n);
+        samples += n;
+        count -= n;
+        samplesSinceHop += n;
+
+        if (samplesSinceHop < hopSize)
+            break;
+
+        samplesSinceHop = 0;
+        if (dataset.isFull())
+            processSegment();
+    }
+}
+
+void FFTDataSource::transformWindow() {
+    // copy dataset into the transform buffer with zero padding
+    dataset.copyTo(frame.data());
+    std::fill(frame.begin() + dataset.size(), frame.end(), 0.0);
 
-        // copy a new dataset to use zero padding
-        ComplexArray dataset = this->dataset;
-        dataset.reserve(fftSize);
-        for (auto i = dataset.size(); i < fftSize; ++i) {
-            dataset.push_back({0, 0});
+    if (windowFunction != Fourier::Rectangular) {
+        for (uint32_t i = 0; i < fftSize; ++i) {
+            frame[i] *= window[i];
         }
+    }
+
+    // input is always real, only the non redundant half is computed
+    plan.forward(frame.data(), spectrum.data());
+}
 
-        isDataUpdated = false;
-
-        auto fftResult = Fourier::fft(dataset);
-        QVector<double> x, y;
-        x.reserve(fftResult.size());
-        y.reserve(fftResult.size());
-
-        uint64_t i;
-
-        auto xVal = std::function<double(ComplexArray::const_iterator)>();
-        auto yVal = std::function<double(ComplexArray::const_iterator)>();
-
-        if (workMode == Amplitude) {
-            xVal = [&i, this](auto it) { return 1e6 * (i++) / step / fftSize; };
-            yVal = [this](auto it) {
-                return std::pow(
-                           std::pow(it->real(), 2) + std::pow(it->imag(), 2),
-                           0.5) /
-                       (fftSize / 2);
-            };
-        } else {
-            xVal = [&i, this](auto it) { return 1e6 * (i++) / step / fftSize; };
-            yVal = [this](auto it) {
-                return std::atan2(it->imag(), it->real()) * 180 / M_PI;
-            };
+void FFTDataSource::processSegment() {
+    transformWindow();
+
+    auto binCount = spectrum.size();
+
+    if (averagingMode == LinearAveraging) {
+        // running sum over the last averageFrames segments
+        auto& oldest = powerHistory[powerHistoryIndex];
+        for (std::size_t i = 0; i < binCount; ++i) {
+            auto power = std::norm(spectrum[i]);
+            averagedPower[i] += power - oldest[i];
+            oldest[i] = power;
         }
 
-        i = 0;
-        for (auto pIt = fftResult.cbegin();
-             pIt != fftResult.cend() - fftSize / 2; ++pIt) {
-            x.append(xVal(pIt));
-            y.append(yVal(pIt));
+        powerHistoryIndex = (powerHistoryIndex + 1) % powerHistory.size();
+        averagedSegments =
+            std::min<std::size_t>(averagedSegments + 1, powerHistory.size());
+
+        // rebuild the sum once per cycle so rounding errors can't pile up
+        if (powerHistoryIndex == 0) {
+            std::ranges::fill(averagedPower, 0.0);
+            for (const auto& history : powerHistory) {
+                for (std::size_t i = 0; i < binCount; ++i) {
+                    averagedPower[i] += history[i];
+                }
+            }
+        }
+    } else {
+        auto alpha = averagedSegments == 0 ? 1.0 : 1.0 / averageFrames;
+        for (std::size_t i = 0; i < binCount; ++i) {
+            averagedPower[i] +=
+                alpha * (std::norm(spectrum[i]) - averagedPower[i]);
         }
 
-        y[0] /= 2;
+        ++averagedSegments;
+    }
+
+    isDataUpdated = true;
+    scheduleFrame();
+}
+
+void FFTDataSource::resetAveraging() {
+    samplesSinceHop = 0;
+    averagedSegments = 0;
+    powerHistoryIndex = 0;
+    averagedPower.assign(fftSize / 2 + 1, 0.0);
 
+    if (averagingMode == LinearAveraging)
+        powerHistory.assign(averageFrames,
+                            std::vector<double>(fftSize / 2 + 1, 0.0));
+    else
+        powerHistory.clear();
+}
+
+void FFTDataSource::processFrame() {
+    if (!isDataUpdated || isTerminateSerial)
+        return;
+
+    // nothing to publish before the first complete segment
+    if (averagingMode != NoAveraging && averagedSegments == 0)
+        return;
+
+    lastFrameTime.restart();
+
+    // detect is steo us undefined
+    if (step == 0) {
         emit controlWordReceived(currentSelectedChannel,
-                                 DataControlWords::ClearDatas);
-        clearQueuedData();
-        appendData(x, y);
+                                 DataControlWords::SetXAxisStep,
+                                 QByteArray::number(1));
+        emit error("FFTDataSource: step is undefined, reset to 1");
     }
 
-    emit finished();
+    isDataUpdated = false;
+
+    // with averaging, spectrum already holds the latest segment
+    if (averagingMode == NoAveraging)
+        transformWindow();
+
+    // bins are equally spaced, x is implicit
+    auto binCount = fftSize / 2;
+    std::shared_ptr<SampleBlock> y[SpectrumOutputCount];
+    for (auto output = 0; output < SpectrumOutputCount; ++output) {
+        if (!enabledOutputs[output])
+            continue;
+
+        y[output] = std::make_shared<SampleBlock>(output, 0.0,
+                                                  1e6 / step / fftSize);
+        y[output]->reserve(binCount);
+    }
+
+    // linear average still filling up only holds averagedSegments segments
+    auto powerScale =
+        averagingMode == LinearAveraging ? 1.0 / averagedSegments : 1.0;
+
+    for (uint32_t i = 0; i < binCount; ++i) {
+        const auto& bin = spectrum[i];
+
+        auto magnitude = averagingMode == NoAveraging
+                             ? std::abs(bin)
+                             : std::sqrt(averagedPower[i] * powerScale);
+
+        // DC bin is not mirrored, it only gets half the scale
+        auto amplitude = magnitude * (i == 0 ? 1 : 2) / windowGain;
+
+        if (enabledOutputs[Amplitude])
+            y[Amplitude]->append(amplitude);
+        if (enabledOutputs[Phase])
+            y[Phase]->append(std::arg(bin) * 180 / M_PI);
+        if (enabledOutputs[PowerDB])
+            y[PowerDB]->append(20 * std::log10(std::max(amplitude, 1e-12)));
+    }
+
+    // every frame replaces the previous one in the plots
+    for (auto output = 0; output < SpectrumOutputCount; ++output) {
+        if (!enabledOutputs[output])
+            continue;
+
+        replaceData(output, std::move(y[output]));
+    }
 }
 
 void FFTDataSource::clearAllData() {
     dataset.clear();
+    resetAveraging();
     isDataUpdated = false;
     DataSource::clearAllData();
 }
 
 
-void FFTDataSource::setFFTSize(uint32_t size) { fftSize = size; }
+void FFTDataSource::setOutputEnabled(SpectrumOutput output, bool isEnabled) {
+    enabledOutputs[output] = isEnabled;
+    isDataUpdated = true;
+    scheduleFrame();
+}
+
+void FFTDataSource::setFrameRate(int fps) {
+    frameRate = std::max(fps, 1);
+}
+
+void FFTDataSource::setWindowFunction(Fourier::WindowFunction function) {
+    windowFunction = function;
+    window = Fourier::window(windowFunction, fftSize);
+    windowGain = std::accumulate(window.cbegin(), window.cend(), 0.0);
+
+    resetAveraging();
+}
+
+void FFTDataSource::setHopSize(uint32_t size) {
+    hopSize = std::clamp<uint32_t>(size, 1, fftSize);
+    resetAveraging();
+}
+
+void FFTDataSource::setAveraging(AveragingMode mode, uint32_t frames) {
+    averagingMode = mode;
+    averageFrames = std::max<uint32_t>(frames, 1);
+
+    resetAveraging();
+}
+
+void FFTDataSource::setFFTSize(uint32_t size) {
+    // transforms are radix-2 only, round up to the next power of two
+    fftSize = std::bit_ceil(std::max<uint32_t>(size, 2));
+
+    plan = RealFFTPlan{fftSize};
+    frame.resize(fftSize);
+    spectrum.resize(fftSize / 2 + 1);
+    hopSize = std::min(hopSize, fftSize);
+    setWindowFunction(windowFunction);
+
+    // keep the latest samples that still fit into the new window
+    std::vector<double> latest(dataset.size());
+    dataset.copyTo(latest.data());
+    dataset.setCapacity(fftSize);
+    dataset.push(latest.data(), latest.size());
+    isDataUpdated = averagingMode == NoAveraging && !dataset.isEmpty();
+    scheduleFrame();
+}
@@ -9,12 +9,18 @@
  */
 #include "mainwindow.h"
 
+#include <QFileDialog>
+#include <QFileInfo>
 #include <QFontDatabase>
 #include <QHBoxLayout>
 #include <QScreen>
+#include <algorithm>
+#include <chrono>
 #include <ranges>
 
+#include "csvfiledatasource.h"
 #include "fftdatasource.h"
+#include "spectrogramdatasource.h"
 #include "pch.h"
 #include "ui_mainwindow.h"
 
@@ -46,6 +52,20 @@ MainWindow::MainWindow(QWidget* parent)
     bindPushButtons();
 
     currentSelectedPlot = ui->mainPlotWidget;
+
+    ui->readStatus->hide();
+    readStatusTimer = new QTimer{this};
+    readStatusTimer->setInterval(readStatusInterval);
+    connect(readStatusTimer, &QTimer::timeout, this,
+            &MainWindow::updateReadStatus);
+    readStatusTimer->start();
+
+    // a fixed number of threads, however many ports are opened
+    acquisitionThreads = new SourceThreadPool{
+        "Acquisition", std::clamp(QThread::idealThreadCount() / 4, 1, 4),
+        this};
+    computeThreads = new SourceThreadPool{
+        "Compute", std::max(QThread::idealThreadCount() / 2, 1), this};
 }
 
 MainWindow::~MainWindow() {
@@ -60,6 +80,8 @@ MainWindow::~MainWindow() {
                            << "is running:" << thread->isRunning();
 
         if (thread->isRunning()) {
+            // wakes a source blocked on a stream nobody drains anymore
+            thread->requestInterruption();
             thread->exit();
             thread->wait();
 
@@ -98,6 +120,21 @@ void MainWindow::bindPushButtons() {
         serialSettingsDiag->exec();
     });
 
+    // open data file btn
+    connect(ui->bOpenDataFile, &QPushButton::clicked, this, [this]() {
+        printCurrentTime() << "Open data file button clicked";
+
+        auto path = QFileDialog::getOpenFileName(
+            this, "Open data file", {},
+            "CSV files (*.csv *.tsv *.txt);;All files (*)");
+        if (path.isEmpty()) {
+            printCurrentTime() << "Open data file Canceled";
+            return;
+        }
+
+        createFileDataSource(path, InsertAtMainWindow);
+    });
+
     // bClearPlots btn
     connect(ui->bClearPlots, &QPushButton::clicked, this, [this]() {
         printCurrentTime() << "Clear plots button clicked";
@@ -124,12 +161,12 @@ void MainWindow::onSourceControlWordReceived(
                        << DCWData.toStdString();
 }
 
-QCPGraph* MainWindow::createNewPlot(DataSource* source, qsizetype index,
-                                    QString title, QPen color,
-                                    NewDataStrategy strategy,
-                                    ChartWidget::PlotPos_t pos) {
+SampleGraph* MainWindow::createNewPlot(DataSource* source, qsizetype index,
+                                       QString title, QPen color,
+                                       NewDataStrategy strategy,
+                                       ChartWidget::PlotPos_t pos) {
     CustomPlot* rPlot = nullptr;
-    QCPGraph* rSeries = nullptr;
+    SampleGraph* rSeries = nullptr;
 
     switch (strategy) {
         case ReusePlot: {
@@ -188,25 +225,38 @@ void MainWindow::createSerialDataSource(SerialSettings settings,
             &MainWindow::onSourceError);
     connect(serialWorker, &SerialWorker::controlWordReceived, this,
             &MainWindow::onSourceControlWordReceived);
-    connect(serialWorker, &DataSource::finished, this, [this, serialWorker]() {
-        for (auto ids : serialWorker->getIds()) {
-            if (!sourceToThreadMap.contains(ids)) {
-                continue;
-            }
 
-            auto& [workerRef, serialThreadRef] = sourceToThreadMap[ids];
-            workerRef = nullptr;
+    // only the native backends report their reads
+    if (settings.isNativeBackend || settings.isPipelined) {
+        auto meter = std::make_shared<ReadMeter>();
+        readMeters.insert(settings.portName, meter);
+
+        // counted on the worker thread, a queued call per read would flood
+        // the event loop of this one
+        connect(
+            serialWorker, &SerialWorker::portRead, serialWorker,
+            [meter](qint64 bytes, qint64 timestamp) {
+                meter->record(bytes, timestamp);
+            },
+            Qt::DirectConnection);
+    }
 
-            if (serialThreadRef != nullptr && serialThreadRef->isRunning()) {
-                serialThreadRef->quit();
-                serialThreadRef->wait();
-                serialThreadRef->deleteLater();
-                serialThreadRef = nullptr;
-            }
+    connect(serialWorker, &DataSource::finished, this,
+            [this, serialWorker, portName = settings.portName]() {
+                readMeters.remove(portName);
 
-            printCurrentTime() << "Serial thread finished";
-        }
-    });
+                for (auto ids : serialWorker->getIds()) {
+                    if (!sourceToThreadMap.contains(ids)) {
+                        continue;
+                    }
+
+                    sourceToThreadMap[ids].first = nullptr;
+                }
+
+                // the thread is shared with other ports and keeps running
+                serialWorker->deleteLater();
+                printCurrentTime() << "Serial source finished";
+            });
 
     connect(this, &MainWindow::windowExited, serialWorker,
             &DataSource::requestStopDataSource);
@@ -239,12 +289,10 @@ void MainWindow::createSerialDataSource(SerialSettings settings,
                     QPen{QColor{0x57, 0xbe, 0x8a}}, ReusePlot, {-1, -1});
             });
 
-    auto th = new QThread{this};
-    connect(th, &QThread::started, serialWorker, &DataSource::run);
-    connect(th, &QThread::finished, serialWorker, &SerialWorker::deleteLater);
-    serialWorker->moveToThread(th);
-    sourceToThreadMap.insert(serialWorker->getId(0), {serialWorker, th});
-    th->start();
+    // ports share the acquisition threads, their event loops multiplex
+    // every port descriptor
+    sourceToThreadMap.insert(serialWorker->getId(0), {serialWorker, nullptr});
+    acquisitionThreads->start(serialWorker);
 
     // 自动添加FFT图像在其下方
 
@@ -256,60 +304,143 @@ void MainWindow::createSerialDataSource(SerialSettings settings,
         qobject_cast<ChartWidget*>(serialCustomPlot->parentWidget());
     auto serialWidgetPos = serialWidget->getPlotPos(serialCustomPlot);
 
-    // 幅度谱
-    auto fftAmpSource =
-        new FFTDataSource{FFTDataSource::Amplitude, serialWorker};
+    // 频谱引擎, 幅度谱与相位谱共用一次FFT计算
+    auto fftSource = new FFTDataSource{serialWorker};
 
-    connect(this, &MainWindow::windowExited, fftAmpSource,
+    connect(this, &MainWindow::windowExited, fftSource,
             &DataSource::requestStopDataSource);
 
-    connect(ui->bClearPlots, &QPushButton::clicked, fftAmpSource,
+    connect(ui->bClearPlots, &QPushButton::clicked, fftSource,
             &FFTDataSource::clearAllData);
 
-    auto fftAmpPlot =
-        createNewPlot(fftAmpSource, 0, "FFT with " + settings.portName,
-                      QPen{QColor{0xfe, 0x5a, 0x5b}}, ReusePlot,
-                      {serialWidgetPos.first + 1, serialWidgetPos.second});
+    // 幅度谱
+    auto fftAmpPlot = createNewPlot(
+        fftSource, FFTDataSource::Amplitude, "FFT with " + settings.portName,
+        QPen{QColor{0xfe, 0x5a, 0x5b}}, ReusePlot,
+        {serialWidgetPos.first + 1, serialWidgetPos.second});
     auto fftAmpCustomPlot = qobject_cast<CustomPlot*>(fftAmpPlot->parentPlot());
     fftAmpCustomPlot->xAxis->setLabel("Frequency (Hz)");
     fftAmpCustomPlot->yAxis->setLabel("Amptitute (V)");
 
-    auto fftAmpThread = new QThread{this};
-    connect(fftAmpThread, &QThread::started, fftAmpSource, &DataSource::run);
-    connect(fftAmpThread, &QThread::finished, fftAmpSource,
-            &FFTDataSource::deleteLater);
-    connect(th, &QThread::finished, fftAmpThread, &QThread::quit);
-    fftAmpSource->moveToThread(fftAmpThread);
-    sourceToThreadMap.insert(fftAmpSource->getId(0),
-                             {fftAmpSource, fftAmpThread});
-    fftAmpThread->start();
-
     // 相位谱
-    auto fftPhaseSource = new FFTDataSource{FFTDataSource::Phase, serialWorker};
-
-    connect(this, &MainWindow::windowExited, fftPhaseSource,
-            &DataSource::requestStopDataSource);
-
-    connect(ui->bClearPlots, &QPushButton::clicked, fftPhaseSource,
-            &FFTDataSource::clearAllData);
-
-    auto fftPhasePlot =
-        createNewPlot(fftPhaseSource, 0, "FFT with " + settings.portName,
-                      QPen{QColor{0x66, 0xcc, 0xff}}, ReusePlot,
-                      {serialWidgetPos.first + 2, serialWidgetPos.second});
+    auto fftPhasePlot = createNewPlot(
+        fftSource, FFTDataSource::Phase, "FFT with " + settings.portName,
+        QPen{QColor{0x66, 0xcc, 0xff}}, ReusePlot,
+        {serialWidgetPos.first + 2, serialWidgetPos.second});
     auto fftPhaseCustomPlot =
         qobject_cast<CustomPlot*>(fftPhasePlot->parentPlot());
     fftPhaseCustomPlot->xAxis->setLabel("Frequency (Hz)");
     fftPhaseCustomPlot->yAxis->setLabel("Phase (Angle)");
 
-    auto fftPhaseThread = new QThread{this};
-    connect(fftPhaseThread, &QThread::started, fftPhaseSource,
-            &DataSource::run);
-    connect(fftPhaseThread, &QThread::finished, fftPhaseSource,
-            &FFTDataSource::deleteLater);
-    connect(th, &QThread::finished, fftPhaseThread, &QThread::quit);
-    fftPhaseSource->moveToThread(fftPhaseThread);
-    sourceToThreadMap.insert(fftPhaseSource->getId(0),
-                             {fftPhaseSource, fftPhaseThread});
-    fftPhaseThread->start();
+    // 时频图, 由功率谱逐帧生成
+    fftSource->setOutputEnabled(FFTDataSource::PowerDB, true);
+    auto spectrogramSource =
+        new SpectrogramDataSource{fftSource, FFTDataSource::PowerDB};
+
+    connect(this, &MainWindow::windowExited, spectrogramSource,
+            &DataSource::requestStopDataSource);
+
+    auto [spectrogramPlot, spectrogram] = serialWidget->addSpectrogram(
+        spectrogramSource, spectrogramSource->getId(0),
+        {serialWidgetPos.first + 3, serialWidgetPos.second});
+    spectrogramPlot->show();
+
+    // derived sources stop with the port they are derived from
+    connect(serialWorker, &DataSource::finished, fftSource,
+            &DataSource::requestStopDataSource);
+    connect(fftSource, &DataSource::finished, spectrogramSource,
+            &DataSource::requestStopDataSource);
+    connect(fftSource, &DataSource::finished, fftSource,
+            &DataSource::deleteLater);
+    connect(spectrogramSource, &DataSource::finished, spectrogramSource,
+            &DataSource::deleteLater);
+
+    sourceToThreadMap.insert(fftSource->getId(FFTDataSource::Amplitude),
+                             {fftSource, nullptr});
+    sourceToThreadMap.insert(spectrogramSource->getId(0),
+                             {spectrogramSource, nullptr});
+    computeThreads->start({fftSource, spectrogramSource});
+}
+
+void MainWindow::createFileDataSource(QString path, NewDataStrategy strategy) {
+    printCurrentTime() << "Open data file:" << path;
+
+    auto fileSource = new CSVFileDataSource{path};
+    auto fileName = QFileInfo{path}.fileName();
+
+    connect(fileSource, &DataSource::error, this, &MainWindow::onSourceError);
+    connect(fileSource, &DataSource::finished, this, [this, fileSource]() {
+        for (auto ids : fileSource->getIds()) {
+            if (!sourceToThreadMap.contains(ids)) {
+                continue;
+            }
+
+            auto& [workerRef, fileThreadRef] = sourceToThreadMap[ids];
+            workerRef = nullptr;
+
+            if (fileThreadRef != nullptr && fileThreadRef->isRunning()) {
+                fileThreadRef->quit();
+                fileThreadRef->wait();
+                fileThreadRef->deleteLater();
+                fileThreadRef = nullptr;
+            }
+        }
+    });
+
+    connect(this, &MainWindow::windowExited, fileSource,
+            &DataSource::requestStopDataSource);
+
+    // a loaded capture is kept whole, it is bounded by the file anyway
+    createNewPlot(fileSource, 0, fileName, QPen{QColor{0x57, 0xbe, 0x8a}},
+                  strategy)
+        ->setRetention(SampleGraph::KeepAll, 0);
+
+    // 文件的每一列数据各占一个子图
+    connect(fileSource, &DataSource::newDataChannelCreated, this,
+            [this, fileSource, fileName](qsizetype index,
+                                         DataSource::DSID id) {
+                createNewPlot(fileSource, index,
+                              QString{"%1 column %2"}.arg(fileName).arg(index),
+                              QPen{QColor{0x57, 0xbe, 0x8a}}, ReusePlot,
+                              {-1, -1})
+                    ->setRetention(SampleGraph::KeepAll, 0);
+            });
+
+    auto th = new QThread{this};
+    connect(th, &QThread::started, fileSource, &DataSource::run);
+    connect(th, &QThread::finished, fileSource,
+            &CSVFileDataSource::deleteLater);
+    fileSource->moveToThread(th);
+    sourceToThreadMap.insert(fileSource->getId(0), {fileSource, th});
+    th->start();
+}
+
+void MainWindow::updateReadStatus() {
+    ui->readStatus->setVisible(!readMeters.isEmpty());
+    if (readMeters.isEmpty())
+        return;
+
+    using namespace std::chrono;
+    const auto now =
+        duration_cast<nanoseconds>(steady_clock::now().time_since_epoch())
+            .count();
+    const auto seconds = readStatusInterval / 1000.0;
+
+    QStringList lines;
+    for (auto [portName, meter] : readMeters.asKeyValueRange()) {
+        auto summary = meter->take();
+        if (summary.lastRead == 0) {
+            lines << QString{"%1: no reads yet"}.arg(portName);
+            continue;
+        }
+
+        lines << QString{"%1: %2 kB/s in %3 reads/s, longest gap %4 ms, "
+                         "last read %5 ms ago"}
+                     .arg(portName)
+                     .arg(summary.bytes / seconds / 1000, 0, 'f', 1)
+                     .arg(summary.reads / seconds, 0, 'f', 0)
+                     .arg(summary.longestGap / 1e6, 0, 'f', 1)
+                     .arg((now - summary.lastRead) / 1e6, 0, 'f', 1);
+    }
+    ui->readStatus->setText(lines.join('\n'));
 }
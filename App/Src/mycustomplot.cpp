@@ -13,6 +13,9 @@
 
 #include <QMouseEvent>
 #include <QTimer>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 #include "globalSettings.h"
 
@@ -31,6 +34,558 @@ void DataLabel::setData(QPair<double, double> data) {
     adjustSize();
 }
 
+SpectrogramColorMap::SpectrogramColorMap(QCPAxis* keyAxis, QCPAxis* valueAxis)
+    : QCPColorMap{keyAxis, valueAxis} {
+    setGradient(QCPColorGradient::gpJet);
+    setInterpolate(false);
+}
+SpectrogramColorMap::~SpectrogramColorMap() {}
+
+void SpectrogramColorMap::setHistorySize(int rows) {
+    rows = std::max(rows, 1);
+    if (rows == historyRows)
+        return;
+
+    historyRows = rows;
+    resetRows(columnCount, mMapData->keyRange());
+}
+
+void SpectrogramColorMap::appendRow(const QVector<double>& row,
+                                    QCPRange keyRange) {
+    if (row.isEmpty())
+        return;
+
+    if (row.size() != columnCount || keyRange != mMapData->keyRange())
+        resetRows(row.size(), keyRange);
+
+    headLine = (headLine + historyRows - 1) % historyRows;
+    rowCount = std::min(rowCount + 1, historyRows);
+
+    auto [minIt, maxIt] = std::minmax_element(row.cbegin(), row.cend());
+    std::copy(row.cbegin(), row.cend(),
+              rowValues.begin() + qsizetype{headLine} * columnCount);
+
+    // grow the color range to the data, recolor everything only then
+    auto rowRange = QCPRange{*minIt, *maxIt};
+    if (rowRange.size() <= 0)
+        rowRange.upper = rowRange.lower + 1;
+
+    if (!isDataRangeValid) {
+        isDataRangeValid = true;
+        setDataRange(rowRange);
+    } else if (!mDataRange.contains(rowRange.lower) ||
+               !mDataRange.contains(rowRange.upper)) {
+        rowRange.expand(mDataRange);
+        setDataRange(rowRange);
+    }
+
+    if (!mMapImageInvalidated)
+        colorizeLine(headLine);
+}
+
+void SpectrogramColorMap::clearRows() {
+    resetRows(columnCount, mMapData->keyRange());
+    isDataRangeValid = false;
+}
+
+void SpectrogramColorMap::resetRows(int columns, QCPRange keyRange) {
+    columnCount = columns;
+    rowCount = 0;
+    headLine = 0;
+
+    rowValues.assign(qsizetype{historyRows} * columnCount, 0.0f);
+    lineBuffer.resize(columnCount);
+
+    mMapData->setRange(keyRange, QCPRange{-(historyRows - 1.0), 0});
+
+    if (columnCount > 0) {
+        mMapImage = QImage{columnCount, historyRows,
+                           QImage::Format_ARGB32_Premultiplied};
+        mMapImage.fill(Qt::transparent);
+    } else {
+        mMapImage = QImage{};
+    }
+
+    mMapImageInvalidated = false;
+}
+
+void SpectrogramColorMap::colorizeLine(int line) {
+    auto values = rowValues.cbegin() + qsizetype{line} * columnCount;
+    std::copy(values, values + columnCount, lineBuffer.begin());
+
+    mGradient.colorize(lineBuffer.data(), mDataRange,
+                       reinterpret_cast<QRgb*>(mMapImage.scanLine(line)),
+                       columnCount, 1,
+                       mDataScaleType == QCPAxis::stLogarithmic);
+}
+
+void SpectrogramColorMap::updateMapImage() {
+    // gradient or data range changed, recolor the filled rows
+    for (auto age = 0; age < rowCount; ++age) {
+        colorizeLine((headLine + age) % historyRows);
+    }
+
+    mMapImageInvalidated = false;
+}
+
+void SpectrogramColorMap::draw(QCPPainter* painter) {
+    if (rowCount == 0 || mMapImage.isNull())
+        return;
+    if (!mKeyAxis || !mValueAxis)
+        return;
+
+    if (mMapImageInvalidated)
+        updateMapImage();
+
+    applyDefaultAntialiasingHint(painter);
+
+    auto keyRange = mMapData->keyRange();
+    auto valueRange = mMapData->valueRange();
+
+    // cells are centered on their key/value, extend by half a cell
+    auto halfCellKey =
+        columnCount > 1 ? keyRange.size() / (columnCount - 1) / 2 : 0.5;
+    QRectF imageRect =
+        QRectF{coordsToPixels(keyRange.lower - halfCellKey,
+                              valueRange.lower - 0.5),
+               coordsToPixels(keyRange.upper + halfCellKey,
+                              valueRange.upper + 0.5)}
+            .normalized();
+
+    // the ring starts at headLine: [headLine, rows) is drawn on top,
+    // followed by the wrapped part [0, headLine)
+    auto lineHeight = imageRect.height() / historyRows;
+    auto topLines = historyRows - headLine;
+
+    const bool smoothBackup =
+        painter->renderHints().testFlag(QPainter::SmoothPixmapTransform);
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, mInterpolate);
+
+    painter->drawImage(QRectF{imageRect.left(), imageRect.top(),
+                              imageRect.width(), topLines * lineHeight},
+                       mMapImage,
+                       QRectF{0, qreal(headLine), qreal(columnCount),
+                              qreal(topLines)});
+
+    if (headLine > 0) {
+        painter->drawImage(
+            QRectF{imageRect.left(), imageRect.top() + topLines * lineHeight,
+                   imageRect.width(), headLine * lineHeight},
+            mMapImage, QRectF{0, 0, qreal(columnCount), qreal(headLine)});
+    }
+
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, smoothBackup);
+}
+
+SampleGraph::SampleGraph(QCPAxis* keyAxis, QCPAxis* valueAxis)
+    : QCPAbstractPlottable{keyAxis, valueAxis} {
+    setPen(QPen{Qt::blue, 0});
+    setBrush(Qt::NoBrush);
+}
+SampleGraph::~SampleGraph() {}
+
+void SampleGraph::clearData() {
+    sampleData.clear();
+    lineData.clear();
+    resetLevels();
+}
+
+void SampleGraph::updateData(bool isReset) {
+    if (isReset)
+        resetLevels();
+
+    updateLevels();
+    trim();
+}
+
+void SampleGraph::swapSamples(SampleBlock& other) {
+    std::swap(sampleData, other);
+    lineData.clear();
+    updateData(true);
+}
+
+void SampleGraph::setRetention(RetentionPolicy policy, double newLimit) {
+    retention = policy;
+    limit = std::max(newLimit, 0.0);
+    updateData();
+}
+
+void SampleGraph::trim() {
+    if (sampleData.isEmpty())
+        return;
+
+    qsizetype kept = sampleData.size();
+    switch (retention) {
+        case KeepLastSamples:
+            kept = qsizetype(limit);
+            break;
+
+        case KeepLastSpan: {
+            auto lastX = sampleData.xAt(sampleData.size() - 1);
+            kept = sampleData.size() - sampleData.lowerBound(lastX - limit);
+        } break;
+
+        case KeepMemoryBudget: {
+            // removed samples stay in storage until it is compacted, which
+            // happens once they are as many as the kept ones. The levels
+            // add a bucket per levelBase - 1 samples
+            auto sampleBytes =
+                (sampleData.isUniform() ? 1 : 2) * sizeof(double) +
+                double(sizeof(MinMax)) / (levelBase - 1);
+            kept = qsizetype(limit * 1024 * 1024 / sampleBytes / 2);
+        } break;
+
+        default:
+            break;
+    }
+
+    if (kept >= sampleData.size())
+        return;
+
+    auto removed = sampleData.size() - kept;
+    sampleData.removeFirst(removed);
+    removedSamples += removed;
+
+    // buckets entirely before the first kept sample
+    auto bucketSize = levelBase;
+    for (auto& level : levels) {
+        auto dropped = std::min<qsizetype>(
+            removedSamples / bucketSize - level.firstBucket,
+            level.buckets.size());
+        if (dropped > 0) {
+            level.buckets.erase(level.buckets.begin(),
+                                level.buckets.begin() + dropped);
+            level.firstBucket += dropped;
+        }
+        bucketSize *= levelBase;
+    }
+}
+
+void SampleGraph::resetLevels() {
+    levels.clear();
+    removedSamples = 0;
+    indexedSamples = 0;
+}
+
+void SampleGraph::updateLevels() {
+    const auto end = removedSamples + sampleData.size();
+
+    // samples dropped before they were folded in, nothing left to extend
+    if (indexedSamples < removedSamples) {
+        levels.clear();
+        indexedSamples = removedSamples;
+    }
+    if (indexedSamples >= end)
+        return;
+
+    if (levels.empty())
+        levels.push_back(Level{indexedSamples / levelBase, {}});
+
+    // first level from the samples
+    const auto* y = sampleData.y() - removedSamples;
+    auto changedBucket = indexedSamples / levelBase;
+    for (auto i = indexedSamples; i < end;) {
+        auto bucket = i / levelBase;
+        auto bucketEnd = std::min((bucket + 1) * levelBase, end);
+
+        auto& level = levels.front();
+        if (bucket - level.firstBucket == qsizetype(level.buckets.size()))
+            level.buckets.emplace_back();
+
+        auto& minMax = level.buckets[bucket - level.firstBucket];
+        for (; i < bucketEnd; ++i)
+            minMax.add(y[i]);
+    }
+    indexedSamples = end;
+
+    // every level above from the one below, from its first changed bucket
+    for (std::size_t k = 1;; ++k) {
+        if (k == levels.size()) {
+            // a level of a single bucket is never read
+            if (levels.back().buckets.size() < levelBase)
+                break;
+            levels.push_back(Level{levels.back().firstBucket / levelBase, {}});
+        }
+
+        const auto& below = levels[k - 1];
+        auto& level = levels[k];
+        auto belowEnd = below.firstBucket + qsizetype(below.buckets.size());
+        auto levelEnd = (belowEnd + levelBase - 1) / levelBase;
+
+        changedBucket = std::max(changedBucket / levelBase, level.firstBucket);
+        level.buckets.resize(levelEnd - level.firstBucket);
+        for (auto bucket = changedBucket; bucket < levelEnd; ++bucket) {
+            MinMax minMax;
+            auto first = std::max(bucket * levelBase, below.firstBucket);
+            auto last = std::min((bucket + 1) * levelBase, belowEnd);
+            for (auto i = first; i < last; ++i)
+                minMax.add(below.buckets[i - below.firstBucket]);
+
+            level.buckets[bucket - level.firstBucket] = minMax;
+        }
+    }
+}
+
+SampleGraph::MinMax SampleGraph::MinMax::inDomain(
+    QCP::SignDomain domain) const {
+    auto result = *this;
+    if (domain == QCP::sdPositive) {
+        result.min = minPositive;
+        result.maxNegative = -inf;
+    } else if (domain == QCP::sdNegative) {
+        result.max = maxNegative;
+        result.minPositive = inf;
+    }
+    return result;
+}
+
+SampleGraph::MinMax SampleGraph::minMax(qsizetype begin,
+                                        qsizetype end) const {
+    MinMax result;
+    const auto* y = sampleData.y() - removedSamples;
+
+    // samples not folded into the levels yet
+    auto lo = begin + removedSamples;
+    auto hi = std::clamp(indexedSamples, lo, end + removedSamples);
+    for (auto i = hi; i < end + removedSamples; ++i)
+        result.add(y[i]);
+
+    // take the unaligned ends at every level and continue with the aligned
+    // middle one level up, buckets read this way never reach past [lo, hi)
+    for (qsizetype k = -1; lo < hi; ++k) {
+        auto add = [&](qsizetype i) {
+            if (k < 0)
+                result.add(y[i]);
+            else
+                result.add(levels[k].buckets[i - levels[k].firstBucket]);
+        };
+
+        if (k + 1 == qsizetype(levels.size())) {
+            for (; lo < hi; ++lo)
+                add(lo);
+            break;
+        }
+
+        for (; lo < hi && lo % levelBase != 0; ++lo)
+            add(lo);
+        for (; lo < hi && hi % levelBase != 0; --hi)
+            add(hi - 1);
+
+        lo /= levelBase;
+        hi /= levelBase;
+    }
+
+    return result;
+}
+
+void SampleGraph::setScatterStyle(const QCPScatterStyle& style) {
+    scatter = style;
+}
+
+qsizetype SampleGraph::findNearest(double key) const {
+    if (sampleData.isEmpty())
+        return -1;
+
+    auto index = sampleData.lowerBound(key);
+    if (index == sampleData.size())
+        return index - 1;
+    if (index > 0 &&
+        key - sampleData.xAt(index - 1) < sampleData.xAt(index) - key)
+        return index - 1;
+    return index;
+}
+
+QPointF SampleGraph::dataPixelPosition(qsizetype index) const {
+    return coordsToPixels(sampleData.xAt(index), sampleData.y()[index]);
+}
+
+double SampleGraph::selectTest(const QPointF& pos, bool onlySelectable,
+                               QVariant* details) const {
+    if ((onlySelectable && mSelectable == QCP::stNone) ||
+        sampleData.isEmpty())
+        return -1;
+    if (!mKeyAxis || !mValueAxis)
+        return -1;
+    if (!mKeyAxis->axisRect()->rect().contains(pos.toPoint()) &&
+        !mParentPlot->interactions().testFlag(
+            QCP::iSelectPlottablesBeyondAxisRect))
+        return -1;
+
+    // the sample nearest in key, not the nearest line segment
+    double key, value;
+    pixelsToCoords(pos, key, value);
+    auto index = findNearest(key);
+
+    if (details != nullptr)
+        details->setValue(
+            QCPDataSelection{QCPDataRange{int(index), int(index) + 1}});
+    return QCPVector2D{pos - dataPixelPosition(index)}.length();
+}
+
+QCPRange SampleGraph::getKeyRange(bool& foundRange,
+                                  QCP::SignDomain inSignDomain) const {
+    // keys are ascending, the range is given by the first and last sample
+    qsizetype begin = 0;
+    qsizetype end = sampleData.size();
+    if (inSignDomain == QCP::sdPositive)
+        begin = sampleData.upperBound(0);
+    else if (inSignDomain == QCP::sdNegative)
+        end = sampleData.lowerBound(0);
+
+    foundRange = begin < end;
+    if (!foundRange)
+        return {};
+    return {sampleData.xAt(begin), sampleData.xAt(end - 1)};
+}
+
+QCPRange SampleGraph::getValueRange(bool& foundRange,
+                                    QCP::SignDomain inSignDomain,
+                                    const QCPRange& inKeyRange) const {
+    qsizetype begin = 0;
+    qsizetype end = sampleData.size();
+    if (inKeyRange != QCPRange{}) {
+        begin = sampleData.lowerBound(inKeyRange.lower);
+        end = sampleData.upperBound(inKeyRange.upper);
+    }
+
+    // O(log n) in every sign domain, log axes included
+    auto range = minMax(begin, end).inDomain(inSignDomain);
+
+    foundRange = !range.isEmpty();
+    if (!foundRange)
+        return {};
+    return {range.min, range.max};
+}
+
+QPair<qsizetype, qsizetype> SampleGraph::visibleRange() const {
+    auto range = mKeyAxis->range();
+    auto begin = sampleData.lowerBound(range.lower);
+    auto end = sampleData.upperBound(range.upper);
+
+    return {std::max<qsizetype>(begin - 1, 0),
+            std::min(end + 1, sampleData.size())};
+}
+
+bool SampleGraph::getLineData(qsizetype begin, qsizetype end) {
+    lineData.clear();
+
+    auto* keyAxis = mKeyAxis.data();
+    auto* valueAxis = mValueAxis.data();
+    const bool isHorizontal = keyAxis->orientation() == Qt::Horizontal;
+    auto toPoint = [isHorizontal](double keyPixel, double valuePixel) {
+        return isHorizontal ? QPointF{keyPixel, valuePixel}
+                            : QPointF{valuePixel, keyPixel};
+    };
+    auto keyPixel = [this, keyAxis](qsizetype i) {
+        return keyAxis->coordToPixel(sampleData.xAt(i));
+    };
+    const auto* y = sampleData.y();
+
+    // a couple of samples per pixel column are drawn as they are
+    auto pixelSpan = isHorizontal ? keyAxis->axisRect()->width()
+                                  : keyAxis->axisRect()->height();
+    if (end - begin <= 2 * pixelSpan) {
+        lineData.reserve(end - begin);
+        for (auto i = begin; i < end; ++i)
+            lineData.append(
+                toPoint(keyPixel(i), valueAxis->coordToPixel(y[i])));
+        return false;
+    }
+
+    // otherwise the first, lowest, highest and last value of every column,
+    // a column without any value breaks the line. The samples of a column
+    // are found from the key at its edge, their min/max from the levels
+    constexpr auto nan = std::numeric_limits<double>::quiet_NaN();
+    const bool isAscending = keyPixel(end - 1) >= keyPixel(begin);
+    lineData.reserve(4 * (pixelSpan + 4));
+    for (auto i = begin; i < end;) {
+        auto column = std::floor(keyPixel(i));
+        auto edge = keyAxis->pixelToCoord(isAscending ? column + 1 : column);
+        auto next = std::clamp(sampleData.lowerBound(edge), i + 1, end);
+
+        auto range = minMax(i, next);
+        if (range.isEmpty()) {
+            lineData.append(toPoint(column, nan));
+            i = next;
+            continue;
+        }
+
+        auto first = std::isnan(y[i]) ? range.min : y[i];
+        auto last = std::isnan(y[next - 1]) ? range.max : y[next - 1];
+        for (auto value : {first, range.min, range.max, last})
+            lineData.append(toPoint(column, valueAxis->coordToPixel(value)));
+
+        i = next;
+    }
+
+    return true;
+}
+
+void SampleGraph::drawLine(QCPPainter* painter) const {
+    auto isBreak = [](const QPointF& point) {
+        return std::isnan(point.x()) || std::isnan(point.y());
+    };
+
+    // one polyline between every two breaks
+    auto segmentBegin = lineData.cbegin();
+    while (segmentBegin != lineData.cend()) {
+        auto segmentEnd = std::find_if(segmentBegin, lineData.cend(), isBreak);
+        if (segmentEnd - segmentBegin > 1)
+            painter->drawPolyline(&*segmentBegin,
+                                  int(segmentEnd - segmentBegin));
+
+        segmentBegin =
+            segmentEnd == lineData.cend() ? segmentEnd : segmentEnd + 1;
+    }
+}
+
+void SampleGraph::draw(QCPPainter* painter) {
+    if (!mKeyAxis || !mValueAxis || sampleData.isEmpty())
+        return;
+
+    auto [begin, end] = visibleRange();
+    if (begin >= end)
+        return;
+
+    auto isReduced = getLineData(begin, end);
+
+    if (mPen.style() != Qt::NoPen && mPen.color().alpha() != 0) {
+        applyDefaultAntialiasingHint(painter);
+        painter->setPen(mPen);
+        painter->setBrush(Qt::NoBrush);
+        drawLine(painter);
+    }
+
+    // scatters only as long as they don't pile up
+    auto pixelSpan = mKeyAxis->orientation() == Qt::Horizontal
+                         ? mKeyAxis->axisRect()->width()
+                         : mKeyAxis->axisRect()->height();
+    if (scatter.isNone() || isReduced ||
+        (end - begin) * scatter.size() > pixelSpan)
+        return;
+
+    applyScattersAntialiasingHint(painter);
+    scatter.applyTo(painter, mPen);
+    for (const auto& point : lineData) {
+        if (!std::isnan(point.x()) && !std::isnan(point.y()))
+            scatter.drawShape(painter, point);
+    }
+}
+
+void SampleGraph::drawLegendIcon(QCPPainter* painter,
+                                 const QRectF& rect) const {
+    applyDefaultAntialiasingHint(painter);
+    painter->setPen(mPen);
+    painter->drawLine(QLineF{rect.left(), rect.center().y(), rect.right() + 5,
+                             rect.center().y()});
+
+    if (!scatter.isNone()) {
+        applyScattersAntialiasingHint(painter);
+        scatter.applyTo(painter, mPen);
+        scatter.drawShape(painter, rect.center());
+    }
+}
+
 CustomPlot::CustomPlot(QWidget* parent) : QCustomPlot{parent} {
     initChart();
     initAxis({});
@@ -45,7 +600,7 @@ CustomPlot::CustomPlot(QWidget* parent) : QCustomPlot{parent} {
 }
 CustomPlot::~CustomPlot() {}
 
-QCPGraph* CustomPlot::addDataSource(DataSource::DSID id) {
+SampleGraph* CustomPlot::addDataSource(DataSource::DSID id) {
     if (id == DataSource::DSID{}) {
         printCurrentTime() << "CustomPlot::addDataSource: id is empty";
         return nullptr;
@@ -56,7 +611,7 @@ QCPGraph* CustomPlot::addDataSource(DataSource::DSID id) {
         return nullptr;
     }
 
-    auto graph = addGraph();
+    auto graph = new SampleGraph{xAxis, yAxis};
 
     graph->setSelectable(QCP::stNone);
 
@@ -65,6 +620,27 @@ QCPGraph* CustomPlot::addDataSource(DataSource::DSID id) {
     return graph;
 }
 
+SpectrogramColorMap* CustomPlot::addSpectrogram(DataSource::DSID id) {
+    if (id == DataSource::DSID{}) {
+        printCurrentTime() << "CustomPlot::addSpectrogram: id is empty";
+        return nullptr;
+    }
+
+    if (isDataSourceExist(id)) {
+        printCurrentTime()
+            << "CustomPlot::addSpectrogram: id is already exist";
+        return nullptr;
+    }
+
+    auto spectrogram = new SpectrogramColorMap{xAxis, yAxis};
+
+    spectrogram->setSelectable(QCP::stNone);
+
+    sourceToSpectrogramMap.insert(id, spectrogram);
+
+    return spectrogram;
+}
+
 void CustomPlot::removeDataSource(DataSource::DSID id) {
     if (id == DataSource::DSID{}) {
         printCurrentTime() << "CustomPlot::removeDataSource: id is empty";
@@ -76,12 +652,15 @@ void CustomPlot::removeDataSource(DataSource::DSID id) {
         return;
     }
 
-    auto graph = getGraph(id);
-    removeGraph(graph);
-    sourceToGraphMap.remove(id);
+    if (sourceToSpectrogramMap.contains(id)) {
+        removePlottable(sourceToSpectrogramMap.take(id));
+        return;
+    }
+
+    removePlottable(sourceToGraphMap.take(id));
 }
 
-QCPGraph* CustomPlot::getGraph(DataSource::DSID id) {
+SampleGraph* CustomPlot::getGraph(DataSource::DSID id) {
     auto it = sourceToGraphMap.find(id);
 
     if (it == sourceToGraphMap.end()) {
@@ -91,8 +670,17 @@ QCPGraph* CustomPlot::getGraph(DataSource::DSID id) {
     return it.value();
 }
 
+QList<SampleGraph*> CustomPlot::getGraphs() const {
+    return sourceToGraphMap.values();
+}
+
+QList<SpectrogramColorMap*> CustomPlot::getSpectrograms() const {
+    return sourceToSpectrogramMap.values();
+}
+
 bool CustomPlot::isDataSourceExist(DataSource::DSID id) const {
-    return sourceToGraphMap.contains(id);
+    return sourceToGraphMap.contains(id) ||
+           sourceToSpectrogramMap.contains(id);
 }
 
 void CustomPlot::setPlotUnit(QByteArray xUnit, QByteArray yUnit){
@@ -101,6 +689,15 @@ void CustomPlot::setPlotUnit(QByteArray xUnit, QByteArray yUnit){
     // TODO set dynamic label
 }
 
+void CustomPlot::clearAllData() {
+    for (auto graph : sourceToGraphMap) {
+        graph->clearData();
+    }
+    for (auto spectrogram : sourceToSpectrogramMap) {
+        spectrogram->clearRows();
+    }
+}
+
 void CustomPlot::initChart() {
     setBackground(QBrush{QColor{Qt::GlobalColor::white}});
 
@@ -109,24 +706,33 @@ void CustomPlot::initChart() {
     axisRect()->setRangeZoom(Qt::Horizontal);
 
     connect(this, &QCustomPlot::beforeReplot, this, [this]() {
-        // zoom y to Fix screen.
-        for (int i = 0; i != graphCount(); ++i) {
-            graph(i)->rescaleValueAxis(false, true);
+        // zoom y to Fix screen, every graph in the visible key range
+        bool isFirst = true;
+        for (auto graph : sourceToGraphMap) {
+            graph->rescaleValueAxis(!isFirst, true);
+            isFirst = false;
         }
     });
 
     connect(this, &QCustomPlot::mouseMove, this, [this](QMouseEvent* event) {
+        // the label follows the last added graph
+        SampleGraph* graph = nullptr;
+        for (auto i = plottableCount() - 1; i >= 0 && graph == nullptr; --i)
+            graph = qobject_cast<SampleGraph*>(plottable(i));
+        if (graph == nullptr)
+            return;
+
         QVariant variant;
-        graph()->selectTest(event->pos(), false, &variant);
+        graph->selectTest(event->pos(), false, &variant);
         auto res = static_cast<QCPDataSelection*>(variant.data());
 
         // show data label move with mouse
         if (res != nullptr && res->dataPointCount() > 0) {
             auto dataIndex = res->dataRange().begin();
-            auto dataValue = *graph()->data()->at(dataIndex);
-            auto dataPos = graph()->dataPixelPosition(dataIndex);
+            auto dataPos = graph->dataPixelPosition(dataIndex);
 
-            dataLabel->setData({dataValue.key, dataValue.value});
+            dataLabel->setData({graph->samples().xAt(dataIndex),
+                                graph->samples().y()[dataIndex]});
 
             auto xAxisRect = plotLayout()->elements(false).first()->rect();
             auto currentY = dataPos.y();
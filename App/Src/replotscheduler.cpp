@@ -0,0 +1,95 @@
+/**
+ * @file replotscheduler.cpp
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#include "replotscheduler.h"
+
+#include <QCoreApplication>
+#include <QGuiApplication>
+#include <QScreen>
+#include <algorithm>
+#include <cmath>
+
+#include "pch.h"
+#include "qcustomplot.h"
+
+ReplotScheduler::ReplotScheduler(QObject* parent)
+    : QObject{parent}, frameTimer{new QTimer{this}} {
+    frameTimer->setTimerType(Qt::PreciseTimer);
+    connect(frameTimer, &QTimer::timeout, this, &ReplotScheduler::onFrame);
+
+    if (auto screen = QGuiApplication::primaryScreen(); screen != nullptr)
+        connect(screen, &QScreen::refreshRateChanged, this,
+                &ReplotScheduler::updateInterval);
+
+    updateInterval();
+    frameTimer->start();
+}
+
+ReplotScheduler* ReplotScheduler::instance() {
+    // owned by the application so the timer dies before the event loop
+    static auto scheduler = new ReplotScheduler{QCoreApplication::instance()};
+    return scheduler;
+}
+
+void ReplotScheduler::setFrameRate(double hz) {
+    requestedFrameRate = std::max(hz, 0.0);
+    updateInterval();
+}
+
+double ReplotScheduler::frameRate() const {
+    if (requestedFrameRate > 0)
+        return requestedFrameRate;
+
+    auto screen = QGuiApplication::primaryScreen();
+    auto rate = screen == nullptr ? 0 : screen->refreshRate();
+    return rate > 0 ? rate : fallbackFrameRate;
+}
+
+void ReplotScheduler::updateInterval() {
+    auto rate = frameRate();
+    frameTimer->setInterval(std::max(int(std::lround(1000 / rate)), 1));
+
+    printCurrentTime() << "ReplotScheduler: frame rate" << rate << "Hz";
+}
+
+void ReplotScheduler::markDirty(QCustomPlot* plot, bool isRescaleAxes) {
+    if (plot == nullptr)
+        return;
+
+    dirtyPlots[plot] |= isRescaleAxes;
+
+    if (!watchedPlots.contains(plot)) {
+        watchedPlots.insert(plot);
+        connect(plot, &QObject::destroyed, this, [this, plot]() {
+            dirtyPlots.remove(plot);
+            watchedPlots.remove(plot);
+        });
+    }
+}
+
+void ReplotScheduler::onFrame() {
+    emit frameStarted();
+    emit frameDrained();
+
+    for (auto it = dirtyPlots.begin(); it != dirtyPlots.end();) {
+        auto plot = it.key();
+
+        // nothing to look at, replot once the window shows up again
+        if (!plot->isVisible() || plot->window()->isMinimized()) {
+            ++it;
+            continue;
+        }
+
+        if (it.value())
+            plot->rescaleAxes();
+        plot->replot(QCustomPlot::rpQueuedReplot);
+
+        it = dirtyPlots.erase(it);
+    }
+}
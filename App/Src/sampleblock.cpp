@@ -0,0 +1,141 @@
+/**
+ * @file sampleblock.cpp
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#include "sampleblock.h"
+
+#include <algorithm>
+#include <cmath>
+
+SampleBlock::SampleBlock(qsizetype channel, double t0, double dt)
+    : channelIndex{channel}, x0{t0}, step{dt} {}
+
+void SampleBlock::copyX(qsizetype first, qsizetype n, double* out) const {
+    first += head;
+    if (isXStored) {
+        std::copy_n(xs.data() + first, n, out);
+        return;
+    }
+
+    for (qsizetype i = 0; i < n; ++i)
+        out[i] = x0 + (first + i) * step;
+}
+
+qsizetype SampleBlock::lowerBound(double key) const {
+    if (isXStored)
+        return std::lower_bound(xs.cbegin() + head, xs.cend(), key) -
+               (xs.cbegin() + head);
+    if (step <= 0)
+        return key <= x0 ? 0 : size();
+
+    auto index = std::ceil((key - x0) / step) - head;
+    return qsizetype(std::clamp(index, 0.0, double(size())));
+}
+
+qsizetype SampleBlock::upperBound(double key) const {
+    if (isXStored)
+        return std::upper_bound(xs.cbegin() + head, xs.cend(), key) -
+               (xs.cbegin() + head);
+    if (step <= 0)
+        return key < x0 ? 0 : size();
+
+    auto index = std::floor((key - x0) / step) + 1 - head;
+    return qsizetype(std::clamp(index, 0.0, double(size())));
+}
+
+void SampleBlock::reserve(qsizetype n) {
+    ys.reserve(n);
+    if (isXStored)
+        xs.reserve(n);
+}
+
+void SampleBlock::clear() {
+    ys.clear();
+    xs.clear();
+    head = 0;
+    isXStored = false;
+}
+
+void SampleBlock::setUniform(double t0, double dt) {
+    Q_ASSERT(isEmpty());
+    clear();
+    x0 = t0;
+    step = dt;
+}
+
+bool SampleBlock::isContinuedBy(double firstX, double dt) const {
+    if (isXStored || dt != step)
+        return false;
+
+    auto expected = x0 + ys.size() * step;
+    return std::abs(expected - firstX) <= std::abs(step) * 1e-3;
+}
+
+void SampleBlock::materializeX() {
+    if (isXStored)
+        return;
+
+    xs.reserve(ys.capacity());
+    xs.resize(ys.size());
+    for (std::size_t i = head; i < ys.size(); ++i)
+        xs[i] = x0 + i * step;
+    isXStored = true;
+}
+
+double* SampleBlock::appendY(qsizetype n) {
+    Q_ASSERT(!isXStored);
+    auto offset = ys.size();
+    ys.resize(offset + n);
+    return ys.data() + offset;
+}
+
+void SampleBlock::append(double x, double y) {
+    materializeX();
+    xs.push_back(x);
+    ys.push_back(y);
+}
+
+void SampleBlock::append(const double* x, const double* y, qsizetype n) {
+    materializeX();
+    xs.insert(xs.end(), x, x + n);
+    ys.insert(ys.end(), y, y + n);
+}
+
+void SampleBlock::append(const SampleBlock& other) {
+    if (other.isEmpty())
+        return;
+
+    if (other.isUniform()) {
+        if (isEmpty())
+            setUniform(other.t0(), other.dt());
+        if (isContinuedBy(other.t0(), other.dt())) {
+            ys.insert(ys.end(), other.y(), other.y() + other.size());
+            return;
+        }
+    }
+
+    materializeX();
+    auto offset = xs.size();
+    xs.resize(offset + other.size());
+    other.copyX(0, other.size(), xs.data() + offset);
+    ys.insert(ys.end(), other.y(), other.y() + other.size());
+}
+
+void SampleBlock::removeFirst(qsizetype n) {
+    head += std::clamp<qsizetype>(n, 0, size());
+    if (head < size())
+        return;
+
+    // x0 stays the x of ys[0]
+    if (!isXStored)
+        x0 += head * step;
+    ys.erase(ys.begin(), ys.begin() + head);
+    if (isXStored)
+        xs.erase(xs.begin(), xs.begin() + head);
+    head = 0;
+}
@@ -0,0 +1,175 @@
+/**
+ * @file samplestream.cpp
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#include "samplestream.h"
+
+#include <QThread>
+#include <algorithm>
+#include <memory>
+
+namespace {
+
+/**
+ * @brief copy of every stride-th sample of block from first on
+ */
+SampleBlockPtr slice(const SampleBlock& block, qsizetype first,
+                     qsizetype stride) {
+    auto count = (block.size() - first + stride - 1) / stride;
+    const auto* y = block.y();
+
+    if (block.isUniform()) {
+        auto part = std::make_shared<SampleBlock>(
+            block.channel(), block.xAt(first), block.dt() * stride);
+        auto partY = part->appendY(count);
+        for (qsizetype i = 0; i < count; ++i)
+            partY[i] = y[first + i * stride];
+        return part;
+    }
+
+    auto part = std::make_shared<SampleBlock>(block.channel());
+    part->reserve(count);
+    for (qsizetype i = 0; i < count; ++i) {
+        auto source = first + i * stride;
+        part->append(block.xAt(source), y[source]);
+    }
+    return part;
+}
+
+}  // namespace
+
+SampleStream::SampleStream(std::size_t capacity, DropPolicy policy)
+    : ring{blockCapacity},
+      sampleCapacity{std::max<std::size_t>(capacity, 1)},
+      policy{policy} {}
+
+SampleStream::~SampleStream() {
+    while (discardOldest() != 0)
+        ;
+}
+
+void SampleStream::write(SampleBlockPtr block,
+                         const std::function<bool()>& isCanceled) {
+    std::size_t n = block->size();
+    if (n == 0)
+        return;
+
+    // a Block write larger than capacity() waits for an empty queue
+    if (n > sampleCapacity || !hasRoomFor(n)) {
+        ++overflows;
+
+        switch (policy.load()) {
+            case DropOldest: {
+                // only the latest capacity() samples can survive
+                if (n > sampleCapacity) {
+                    dropped += n - sampleCapacity;
+                    block = slice(*block, qsizetype(n - sampleCapacity), 1);
+                    n = sampleCapacity;
+                }
+                while (!hasRoomFor(n)) {
+                    auto discarded = discardOldest();
+                    // the consumer took the rest, wait for it to count them
+                    if (discarded == 0)
+                        QThread::yieldCurrentThread();
+                    dropped += discarded;
+                }
+            } break;
+
+            case Decimate: {
+                auto size = queued.load(std::memory_order_acquire);
+                auto free = sampleCapacity - std::min(size, sampleCapacity);
+                if (free == 0 || ring.size() == ring.capacity()) {
+                    decimated += n;
+                    return;
+                }
+
+                auto stride = (n + free - 1) / free;
+                block = slice(*block, 0, qsizetype(stride));
+                decimated += n - block->size();
+            } break;
+
+            default:
+                break;
+        }
+    }
+
+    push(std::move(block), isCanceled);
+}
+
+bool SampleStream::push(SampleBlockPtr block,
+                        const std::function<bool()>& isCanceled) {
+    std::size_t n = block->size();
+
+    // only Block waits, the other policies made room already
+    while (!hasRoomFor(n)) {
+        if (policy.load() != Block || isCanceled()) {
+            dropped += n;
+            return false;
+        }
+
+        QThread::usleep(500);
+    }
+
+    // counted first, the consumer subtracts once it popped the block
+    queued.fetch_add(n, std::memory_order_acq_rel);
+    auto entry = new SampleBlockPtr{std::move(block)};
+    ring.push(&entry, 1);
+    return true;
+}
+
+std::size_t SampleStream::discardOldest() {
+    SampleBlockPtr* entry;
+    if (ring.discard(1, &entry) == 0)
+        return 0;
+
+    std::unique_ptr<SampleBlockPtr> block{entry};
+    std::size_t n = (*block)->size();
+    queued.fetch_sub(n, std::memory_order_acq_rel);
+    return n;
+}
+
+void SampleStream::reset() {
+    while (discardOldest() != 0)
+        ;
+    resetIndex.store(ring.writeIndex(), std::memory_order_release);
+}
+
+bool SampleStream::read(SampleBlock& out, bool* isReset) {
+    readBuffer.resize(ring.capacity());
+    std::size_t firstIndex = 0;
+    auto count = ring.pop(readBuffer.data(), readBuffer.size(), &firstIndex);
+
+    // loaded after the pop: a block pushed after a reset() is never read
+    // without seeing that reset
+    auto lastResetIndex = resetIndex.load(std::memory_order_acquire);
+    auto isCleared = lastResetIndex != readResetIndex;
+    readResetIndex = lastResetIndex;
+
+    // blocks popped just before a reset() are replaced by it as well
+    auto skipped = isCleared ? std::min(count, lastResetIndex -
+                                                   std::min(lastResetIndex,
+                                                            firstIndex))
+                             : 0;
+
+    if (isCleared)
+        out.clear();
+    if (isReset != nullptr)
+        *isReset = isCleared;
+
+    for (std::size_t i = 0; i < count; ++i) {
+        std::unique_ptr<SampleBlockPtr> block{readBuffer[i]};
+        queued.fetch_sub((*block)->size(), std::memory_order_acq_rel);
+
+        // stays uniform if the block continues out, x is only stored for
+        // blocks that don't
+        if (i >= skipped)
+            out.append(**block);
+    }
+
+    return isCleared || count > skipped;
+}
@@ -0,0 +1,319 @@
+/**
+ * @file scope.cpp
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#include "scope.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "pch.h"
+#include "replotscheduler.h"
+
+Scope::Scope(QObject* parent) : QObject{parent} {}
+
+void Scope::setEnabled(bool isEnabled) {
+    if (isEnabled == isScopeEnabled)
+        return;
+
+    printCurrentTime() << "Scope::setEnabled" << isEnabled;
+
+    isScopeEnabled = isEnabled;
+
+    // the plain history waits in the channel while frames are on display
+    if (isScopeEnabled) {
+        for (auto graph : graphOrder)
+            graph->swapSamples(channels[graph].history);
+    }
+
+    reset();
+
+    if (!isScopeEnabled) {
+        for (auto graph : graphOrder) {
+            auto& channel = channels[graph];
+            graph->swapSamples(channel.history);
+            channel.history = SampleBlock{};
+        }
+    }
+}
+
+void Scope::addGraph(SampleGraph* graph) {
+    if (graph == nullptr || channels.contains(graph))
+        return;
+
+    graphOrder.append(graph);
+    channels.insert(graph, Channel{});
+    connect(graph, &QObject::destroyed, this,
+            [this, graph]() { removeGraph(graph); });
+
+    if (trigger == nullptr)
+        trigger = graph;
+
+    if (isScopeEnabled) {
+        auto& channel = channels[graph];
+        channel.acquisition.reserve(2 * frameLength);
+        channel.backFrame.reserve(frameLength);
+        graph->swapSamples(channel.history);
+    }
+
+    emit graphsChanged();
+}
+
+void Scope::removeGraph(SampleGraph* graph) {
+    if (!channels.contains(graph))
+        return;
+
+    graphOrder.removeOne(graph);
+    channels.remove(graph);
+
+    if (trigger == graph) {
+        trigger = graphOrder.isEmpty() ? nullptr : graphOrder.first();
+        scanned = 0;
+        pendingTrigger = -1;
+    }
+
+    emit graphsChanged();
+}
+
+void Scope::setTrigger(SampleGraph* graph, Slope slope, double level) {
+    if (graph != nullptr && !channels.contains(graph))
+        return;
+
+    trigger = graph;
+    triggerSlope = slope;
+    triggerLevel = level;
+
+    // the acquisition is kept, only the search starts over
+    scanned = 0;
+    pendingTrigger = -1;
+}
+
+void Scope::setFrame(qsizetype size, double preTriggerRatio) {
+    size = std::max<qsizetype>(size, 1);
+    auto preTrigger = std::clamp<qsizetype>(
+        std::llround(size * preTriggerRatio), 0, size);
+    if (size == frameLength && preTrigger == preTriggerLength)
+        return;
+
+    frameLength = size;
+    preTriggerLength = preTrigger;
+
+    if (isScopeEnabled)
+        reset();
+}
+
+bool Scope::read(SampleGraph* graph, SampleStream& stream) {
+    auto it = channels.find(graph);
+    if (it == channels.end())
+        return false;
+
+    bool isReset;
+    if (!stream.read(it->acquisition, &isReset))
+        return false;
+
+    // the stream restarted, the history before scope mode is stale
+    if (isReset)
+        it->history.clear();
+
+    // the trigger graph restarted, so does the search
+    if (isReset && graph == trigger) {
+        scanned = 0;
+        pendingTrigger = -1;
+    }
+    return true;
+}
+
+qsizetype Scope::findTrigger(const SampleBlock& block, qsizetype first,
+                             Slope slope, double level) {
+    const auto* y = block.y();
+    const auto end = block.size();
+
+    // comparisons with NaN are false, NaN never triggers
+    switch (slope) {
+        case Rising:
+            for (auto i = first; i < end; ++i)
+                if (y[i - 1] < level && y[i] >= level)
+                    return i;
+            break;
+
+        case Falling:
+            for (auto i = first; i < end; ++i)
+                if (y[i - 1] > level && y[i] <= level)
+                    return i;
+            break;
+
+        case Level:
+            for (auto i = first; i < end; ++i)
+                if (y[i] >= level)
+                    return i;
+            break;
+    }
+    return end;
+}
+
+void Scope::capture() {
+    if (!isScopeEnabled)
+        return;
+    if (trigger == nullptr) {
+        dropAcquired();
+        return;
+    }
+
+    const auto& source = channels[trigger].acquisition;
+    const auto postTrigger = frameLength - preTriggerLength;
+
+    // only the last complete frame of this display frame is worth copying
+    qsizetype lastComplete = -1;
+    while (true) {
+        if (pendingTrigger < 0) {
+            auto first = std::max({scanned, preTriggerLength, qsizetype{1}});
+            if (first >= source.size())
+                break;
+
+            scanned = findTrigger(source, first, triggerSlope, triggerLevel);
+            if (scanned == source.size())
+                break;
+            pendingTrigger = scanned;
+        }
+
+        if (pendingTrigger + postTrigger > source.size())
+            break;
+
+        // frames don't overlap, the next trigger comes after this frame
+        lastComplete = pendingTrigger;
+        scanned = pendingTrigger + std::max<qsizetype>(postTrigger, 1);
+        pendingTrigger = -1;
+    }
+
+    if (lastComplete >= 0)
+        captureFrame(lastComplete);
+
+    dropAcquired();
+}
+
+void Scope::reset() {
+    auto scheduler = ReplotScheduler::instance();
+
+    for (auto graph : graphOrder) {
+        auto& channel = channels[graph];
+        if (isScopeEnabled) {
+            channel.acquisition.clear();
+            channel.acquisition.reserve(2 * frameLength);
+            channel.backFrame.clear();
+            channel.backFrame.reserve(frameLength);
+
+            graph->clearData();
+            graph->samples().reserve(frameLength);
+        } else {
+            channel.acquisition = SampleBlock{};
+            channel.backFrame = SampleBlock{};
+        }
+
+        scheduler->markDirty(graph->parentPlot(), true);
+    }
+
+    scanned = 0;
+    pendingTrigger = -1;
+}
+
+void Scope::captureFrame(qsizetype at) {
+    const auto& source = channels[trigger].acquisition;
+    const auto begin = at - preTriggerLength;
+    const auto end = at + frameLength - preTriggerLength;
+
+    // x relative to the trigger, the other graphs give the same x window
+    const auto triggerX = source.xAt(at);
+    const auto firstX = source.xAt(begin);
+    const auto lastX = source.xAt(end - 1);
+
+    auto scheduler = ReplotScheduler::instance();
+    for (auto graph : graphOrder) {
+        auto& channel = channels[graph];
+        const auto& acquisition = channel.acquisition;
+
+        auto first = begin;
+        auto last = end;
+        if (graph != trigger) {
+            first = acquisition.lowerBound(firstX);
+            last = std::clamp(acquisition.upperBound(lastX), first,
+                              first + frameLength);
+        }
+
+        auto& frame = channel.backFrame;
+        frame.clear();
+        if (acquisition.isUniform()) {
+            frame.setUniform(acquisition.xAt(first) - triggerX,
+                             acquisition.dt());
+            std::copy_n(acquisition.y() + first, last - first,
+                        frame.appendY(last - first));
+        } else {
+            for (auto i = first; i < last; ++i)
+                frame.append(acquisition.xAt(i) - triggerX,
+                             acquisition.y()[i]);
+        }
+
+        // the frame on display becomes the next back frame
+        graph->swapSamples(frame);
+        scheduler->markDirty(graph->parentPlot(), true);
+    }
+}
+
+void Scope::dropAcquired() {
+    if (trigger != nullptr)
+        dropBeforeTrigger();
+
+    // bounded whatever the x of the trigger graph, it may stall or count in
+    // another domain
+    const auto maxAcquisition = acquisitionFrames * frameLength;
+    for (auto graph : graphOrder) {
+        auto& acquisition = channels[graph].acquisition;
+        auto excess = acquisition.size() - maxAcquisition;
+        if (excess <= 0)
+            continue;
+
+        acquisition.removeFirst(excess);
+        if (graph != trigger)
+            continue;
+
+        scanned = std::max<qsizetype>(scanned - excess, 0);
+        // lost its pre trigger samples, the search goes on after it
+        if (pendingTrigger >= 0) {
+            pendingTrigger -= excess;
+            if (pendingTrigger < preTriggerLength) {
+                scanned = std::max<qsizetype>(pendingTrigger + 1, 0);
+                pendingTrigger = -1;
+            }
+        }
+    }
+}
+
+void Scope::dropBeforeTrigger() {
+    auto& source = channels[trigger].acquisition;
+
+    // the next trigger candidate needs its pre trigger samples and the one
+    // before it
+    auto keepFrom = pendingTrigger >= 0
+                        ? pendingTrigger - preTriggerLength
+                        : std::min(scanned - preTriggerLength, scanned - 1);
+    keepFrom = std::clamp<qsizetype>(keepFrom, 0, source.size());
+
+    source.removeFirst(keepFrom);
+    scanned -= keepFrom;
+    if (pendingTrigger >= 0)
+        pendingTrigger -= keepFrom;
+
+    // the other graphs keep the x window of the trigger graph
+    for (auto graph : graphOrder) {
+        if (graph == trigger)
+            continue;
+
+        auto& acquisition = channels[graph].acquisition;
+        if (!source.isEmpty())
+            acquisition.removeFirst(acquisition.lowerBound(source.xAt(0)));
+    }
+}
@@ -9,14 +9,39 @@
  */
 #include "serial.h"
 
-#include <QCoreApplication>
 #include <QFormLayout>
 #include <QHBoxLayout>
 #include <QMessageBox>
 #include <QThread>
+#include <algorithm>
+#include <chrono>
 
 #include "pch.h"
 
+#ifdef Q_OS_LINUX
+namespace {
+
+/**
+ * @brief timestamp as sent by SerialWorker::portRead()
+ */
+inline qint64 toNanoseconds(TermiosPort::Clock::time_point timestamp) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               timestamp.time_since_epoch())
+        .count();
+}
+
+/**
+ * @brief time since timestamp in milliseconds
+ */
+inline qint64 millisecondsSince(TermiosPort::Clock::time_point timestamp) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               TermiosPort::Clock::now() - timestamp)
+        .count();
+}
+
+}  // namespace
+#endif
+
 SerialSettingsDiag::SerialSettingsDiag(QDialog *parent) : QDialog{parent} {
     // set delete when close
     setAttribute(Qt::WA_DeleteOnClose);
@@ -36,6 +61,8 @@ SerialSettingsDiag::SerialSettingsDiag(QDialog *parent) : QDialog{parent} {
 
     initCheckBox();
 
+    initSpinBox();
+
     auto currentWidgetLayout = qobject_cast<QFormLayout *>(layout());
 
     currentWidgetLayout->addRow("Port", cActivatedPort);
@@ -44,7 +71,16 @@ SerialSettingsDiag::SerialSettingsDiag(QDialog *parent) : QDialog{parent} {
     currentWidgetLayout->addRow("Data bits", cDataBits);
     currentWidgetLayout->addRow("Parity", cParity);
     currentWidgetLayout->addRow("Flow control", cFlowControl);
+    currentWidgetLayout->addRow("Data format", cDataFormat);
+    currentWidgetLayout->addRow("Min read size", sMinReadSize);
+    currentWidgetLayout->addRow("Max read latency", sMaxReadLatency);
     currentWidgetLayout->addRow(cIsTimeDomainData);
+    if (cIsNativeBackend != nullptr)
+        currentWidgetLayout->addRow(cIsNativeBackend);
+    if (cIsPipelined != nullptr) {
+        currentWidgetLayout->addRow(cIsPipelined);
+        currentWidgetLayout->addRow("Reader core", sReaderCore);
+    }
     currentWidgetLayout->addRow(rButtonsLayout);
 
     // lock the size of the dialog
@@ -88,8 +124,21 @@ void SerialSettingsDiag::initBtns() {
 
         settings.portName = settings.port.portName();
 
+        settings.sourceType = static_cast<DataStreamParser::SourceType>(
+            cDataFormat->currentData().toInt());
+
         settings.isTimeDomainData = cIsTimeDomainData->isChecked();
 
+        settings.minReadSize = sMinReadSize->value();
+        settings.maxReadLatency = sMaxReadLatency->value();
+
+        settings.isNativeBackend =
+            cIsNativeBackend != nullptr && cIsNativeBackend->isChecked();
+        settings.isPipelined =
+            cIsPipelined != nullptr && cIsPipelined->isChecked();
+        settings.readerCore =
+            sReaderCore != nullptr ? sReaderCore->value() : -1;
+
         emit settingsReceived(settings);
         close();
     });
@@ -152,12 +201,57 @@ void SerialSettingsDiag::initComboBox() {
     cFlowControl->addItem("No Flow Control", QSerialPort::NoFlowControl);
     cFlowControl->addItem("Hardware Control", QSerialPort::HardwareControl);
     cFlowControl->addItem("Software Control", QSerialPort::SoftwareControl);
+
+    cDataFormat = new QComboBox{this};
+    cDataFormat->setEditable(false);
+
+    cDataFormat->addItem(
+        "Text", static_cast<int>(DataStreamParser::SourceType::StringStream));
+    cDataFormat->addItem(
+        "Binary frame",
+        static_cast<int>(DataStreamParser::SourceType::BinaryFrame));
 }
 
 void SerialSettingsDiag::initCheckBox() {
     cIsTimeDomainData = new QCheckBox{"is Time domain data", this};
 
     cIsTimeDomainData->setChecked(true);
+
+#ifdef Q_OS_LINUX
+    cIsNativeBackend = new QCheckBox{"Native termios backend", this};
+    cIsNativeBackend->setToolTip(
+        "Open the port through termios with low latency settings");
+
+    cIsPipelined = new QCheckBox{"Pipelined reader", this};
+    cIsPipelined->setToolTip(
+        "Read, parse and dispatch on separate threads, for one fast port");
+#endif
+}
+
+void SerialSettingsDiag::initSpinBox() {
+    sMinReadSize = new QSpinBox{this};
+    sMinReadSize->setRange(1, 1 << 20);
+    sMinReadSize->setSuffix(" bytes");
+    sMinReadSize->setValue(SerialWorker::defaultMinReadSize);
+    sMinReadSize->setToolTip("Bytes to wait for before a read");
+
+    sMaxReadLatency = new QSpinBox{this};
+    sMaxReadLatency->setRange(0, 1000);
+    sMaxReadLatency->setSuffix(" ms");
+    sMaxReadLatency->setValue(SerialWorker::defaultMaxReadLatency);
+    sMaxReadLatency->setToolTip(
+        "Longest wait for the min read size before reading anyway");
+
+#ifdef Q_OS_LINUX
+    sReaderCore = new QSpinBox{this};
+    sReaderCore->setRange(-1, QThread::idealThreadCount() - 1);
+    sReaderCore->setSpecialValueText("Any");
+    sReaderCore->setValue(-1);
+    sReaderCore->setToolTip("Core the pipelined reader is pinned to");
+    sReaderCore->setEnabled(false);
+    connect(cIsPipelined, &QCheckBox::toggled, sReaderCore,
+            &QSpinBox::setEnabled);
+#endif
 }
 
 SerialWorker::SerialWorker(QObject *parent)
@@ -172,44 +266,22 @@ SerialWorker::~SerialWorker() {
 void SerialWorker::setSerialSettings(SerialSettings settings) {
     QMutexLocker locker{&mutex};
     this->settings = settings;
+    setSourceType(settings.sourceType);
 }
 
 bool SerialWorker::openSerial() {
-    if (serial->open(QIODevice::ReadWrite)) {
-        serial->write("Ok!");
-        return true;
-    } else {
-        emit error(serial->errorString());
-        return false;
-    }
-}
-
-void SerialWorker::run() {
-    printCurrentTime() << "SerialWorker::run() @" << QThread::currentThreadId();
-
-    bool isStoped = false;
-
     serial = new QSerialPort{this};
 
-    auto tagToExit = [&]() {
-        if (!(isStoped = !isStoped))
-            return;
-
-        requestStopDataSource();
-        emit finished();
-        printCurrentTime() << "SerialWorker::run() end";
-    };
-
     connect(serial, &QSerialPort::aboutToClose, this,
             &SerialWorker::requestStopDataSource);
 
     connect(serial, &QSerialPort::errorOccurred, this,
-            [this, tagToExit](QSerialPort::SerialPortError e) {
+            [this](QSerialPort::SerialPortError e) {
                 if (e == QSerialPort::NoError || e == QSerialPort::TimeoutError)
                     return;
 
                 emit error(serial->errorString());
-                tagToExit();
+                requestStopDataSource();
             });
 
     {
@@ -222,100 +294,411 @@ void SerialWorker::run() {
         serial->setPort(settings.port);
     }
 
-    if (!openSerial()) {
+    if (serial->open(QIODevice::ReadWrite)) {
+        serial->write("Ok!");
+        return true;
+    } else {
         emit error("Can't open serial port:" + serial->errorString());
-        tagToExit();
-        return;
+        return false;
     }
+}
 
-    auto parseDataAndSend = [&]() {
-        auto result = parseData();
-        if (result == std::nullopt) {
-            return false;
-        }
+bool SerialWorker::openNativeSerial() {
+#ifdef Q_OS_LINUX
+    nativePort = std::make_unique<TermiosPort>();
+
+    QString path;
+    auto config = nativePortConfig(path);
+    if (!nativePort->open(path, config)) {
+        emit error("Can't open serial port:" + nativePort->errorString());
+        return false;
+    }
+
+    printCurrentTime() << "SerialWorker: native port" << path
+                       << "low latency" << nativePort->isLowLatency();
+
+    nativePort->write("Ok!", 3);
+
+    readNotifier = new QSocketNotifier{nativePort->descriptor(),
+                                       QSocketNotifier::Read, this};
+    recheckTimer = new QTimer{this};
+    recheckTimer->setSingleShot(true);
+    recheckTimer->setTimerType(Qt::PreciseTimer);
+    recheckTimer->setInterval(recheckInterval);
+    return true;
+#else
+    emit error("The native serial backend is only available on Linux");
+    return false;
+#endif
+}
+
+bool SerialWorker::openPipeline() {
+#ifdef Q_OS_LINUX
+    QString path;
+    auto config = nativePortConfig(path);
+    // the reader blocks in read(), VTIME bounds it so it sees stop requests
+    config.isBlocking = true;
+    config.vmin = 0;
+    config.vtime = 1;
+
+    auto port = std::make_unique<TermiosPort>();
+    if (!port->open(path, config)) {
+        emit error("Can't open serial port:" + port->errorString());
+        return false;
+    }
+
+    printCurrentTime() << "SerialWorker: pipelined port" << path
+                       << "low latency" << port->isLowLatency();
+
+    port->write("Ok!", 3);
+
+    pipeline = std::make_unique<SerialPipeline>(std::move(port), this,
+                                                sourceType(), isStart);
+
+    int maxReadLatency;
+    {
+        QMutexLocker locker{&mutex};
+        maxReadLatency = settings.maxReadLatency;
+    }
+
+    dispatchTimer = new QTimer{this};
+    dispatchTimer->setTimerType(Qt::PreciseTimer);
+    // no need to dispatch faster than the samples are published
+    dispatchTimer->setInterval(std::clamp(maxReadLatency, 1, 1000 / 30));
+    connect(dispatchTimer, &QTimer::timeout, this,
+            &SerialWorker::dispatchParsed);
+
+    statsTimer = new QTimer{this};
+    statsTimer->setInterval(pipelineStatsInterval);
+    connect(statsTimer, &QTimer::timeout, this,
+            &SerialWorker::logPipelineStats);
+    return true;
+#else
+    emit error("The pipelined serial reader is only available on Linux");
+    return false;
+#endif
+}
+
+#ifdef Q_OS_LINUX
+TermiosPort::Config SerialWorker::nativePortConfig(QString &path) {
+    QMutexLocker locker{&mutex};
+
+    TermiosPort::Config config;
+    path = settings.port.systemLocation();
+    config.baudRate = settings.baudRate;
+    config.dataBits = settings.dataBits;
+    // termios has no mark or space parity, nor 1.5 stop bits
+    config.parity = settings.parity == QSerialPort::EvenParity
+                        ? TermiosPort::EvenParity
+                    : settings.parity == QSerialPort::OddParity
+                        ? TermiosPort::OddParity
+                        : TermiosPort::NoParity;
+    config.isTwoStopBits = settings.stopBits == QSerialPort::TwoStop;
+    config.isHardwareFlowControl =
+        settings.flowControl == QSerialPort::HardwareControl;
+    config.isSoftwareFlowControl =
+        settings.flowControl == QSerialPort::SoftwareControl;
+    return config;
+}
+
+void SerialWorker::dispatchParsed() {
+    auto stats = pipeline->stats();
+    if (stats.reads > 0 && stats.lastReadTime != lastPipelineRead) {
+        lastPipelineRead = stats.lastReadTime;
+        emit portRead(stats.lastReadBytes, toNanoseconds(lastPipelineRead));
+    }
 
-        switch (result->first) {
-            case DataStreamParser::RDataType::RDataPointF: {
-                auto data = result->second.toPointF();
-                DataSource::appendData({data.x()}, {data.y()});
+    isDispatching = true;
+
+    while (auto item = pipeline->pop()) {
+        switch (item->kind) {
+            case SerialPipeline::Item::Samples: {
+                DataSource::appendData(item->channel, std::move(item->block));
             } break;
 
-            case DataStreamParser::RDataType::RDataControlWord: {
-                auto [controlWord, controlWordData] =
-                    DataSource::parseControlWord(result->second.toByteArray());
-                emit controlWordReceived(currentSelectedChannel, controlWord,
-                                         controlWordData);
+            case SerialPipeline::Item::ControlWord: {
+                emit controlWordReceived(currentSelectedChannel,
+                                         item->controlWord, item->data);
             } break;
 
-            case DataStreamParser::RDataType::RDataErrorString: {
-                emit error(result->second.toString());
+            case SerialPipeline::Item::ErrorString: {
+                emit error(item->errorString);
             } break;
+
+            case SerialPipeline::Item::PortError: {
+                isDispatching = false;
+                emit error(item->errorString);
+                requestStopDataSource();
+                return;
+            }
         }
+    }
 
-        return true;
-    };
+    isDispatching = false;
+}
 
-    bool isStart = false;
-    auto detectSerialStartFlag = [&]() {
-        QByteArray inputBuffer{};
-        QCoreApplication::processEvents();
-        while (!isStart) {
-            QCoreApplication::processEvents();
+void SerialWorker::logPipelineStats() {
+    auto stats = pipeline->stats();
+
+    printCurrentTime() << "SerialPipeline: reader" << stats.bytesRead
+                       << "bytes in" << stats.reads << "reads, stalled"
+                       << stats.readerStalls;
+    if (stats.reads > 0)
+        printCurrentTime() << "SerialPipeline: last read" << stats.lastReadBytes
+                           << "bytes" << millisecondsSince(stats.lastReadTime)
+                           << "ms ago";
+    printCurrentTime() << "SerialPipeline: byte queue" << stats.byteQueueSize
+                       << "peak" << stats.byteQueuePeak << "of"
+                       << stats.byteQueueCapacity;
+    printCurrentTime() << "SerialPipeline: parser" << stats.parsedBytes
+                       << "bytes, idle" << stats.parserIdles << "stalled"
+                       << stats.parserStalls;
+    printCurrentTime() << "SerialPipeline: item queue" << stats.itemQueueSize
+                       << "peak" << stats.itemQueuePeak << "of"
+                       << stats.itemQueueCapacity << ", dispatched"
+                       << stats.dispatchedItems;
+}
+#endif
+
+bool SerialWorker::isPortOpen() const {
+#ifdef Q_OS_LINUX
+    if (nativePort != nullptr)
+        return nativePort->isOpen();
+#endif
+    return serial != nullptr && serial->isOpen();
+}
 
-            if (isTerminateSerial) {
-                break;
-            }
+qint64 SerialWorker::bytesAvailable() const {
+#ifdef Q_OS_LINUX
+    if (nativePort != nullptr)
+        return nativePort->bytesAvailable();
+#endif
+    return serial->bytesAvailable();
+}
 
-            if (!serial->waitForReadyRead(200))
-                continue;
+qint64 SerialWorker::readPort() {
+    auto size = std::max(bytesAvailable(), minReadChunk);
+    auto data = DataStreamParser::prepareData(size);
+
+#ifdef Q_OS_LINUX
+    if (nativePort != nullptr) {
+        auto info = nativePort->read(data, size);
+        if (info.bytes < 0) {
+            emit error(nativePort->errorString());
+            requestStopDataSource();
+            return 0;
+        }
 
-            inputBuffer.append(serial->readAll());
+        lastRead = info;
+        ++readCount;
+        readBytes += info.bytes;
+        emit portRead(info.bytes, toNanoseconds(info.timestamp));
 
-            if (!inputBuffer.contains("%START")) {
-                inputBuffer = inputBuffer.last(
-                    inputBuffer.size() < 5 ? inputBuffer.size() : 5);
-                continue;
-            }
+        DataStreamParser::commitData(info.bytes);
+        return info.bytes;
+    }
+#endif
 
-            DataStreamParser::appendData(
-                inputBuffer.mid(inputBuffer.indexOf("%START")));
-            parseDataAndSend();
-            isStart = true;
-        }
-    };
+    // errors come through errorOccurred
+    auto bytes = serial->read(data, size);
+    if (bytes <= 0)
+        return 0;
 
-    while (!isTerminateSerial && serial->isOpen()) {
-        // process events
-        QCoreApplication::processEvents();
+    DataStreamParser::commitData(bytes);
+    return bytes;
+}
 
-        if (isTerminateSerial)
-            break;
+void SerialWorker::run() {
+    printCurrentTime() << "SerialWorker::run() @" << QThread::currentThreadId();
 
-        if (!isStart)
-            detectSerialStartFlag();
+    latencyTimer = new QTimer{this};
 
-        if (!serial->waitForReadyRead(200))
-            continue;
+    bool isNativeBackend;
+    bool isPipelined;
+    [[maybe_unused]] int readerCore;
+    {
+        QMutexLocker locker{&mutex};
+        isNativeBackend = settings.isNativeBackend;
+        isPipelined = settings.isPipelined;
+        readerCore = settings.readerCore;
 
-        auto d = serial->readAll();
-        DataStreamParser::appendData(d);
-        while (parseDataAndSend())
-            ;
+        latencyTimer->setSingleShot(true);
+        latencyTimer->setTimerType(Qt::PreciseTimer);
+        latencyTimer->setInterval(settings.maxReadLatency);
+    }
+
+    // binary frames resync by themselves, there is no %START to wait for
+    isStart = sourceType() == DataStreamParser::SourceType::BinaryFrame;
+
+    auto isOpened = isPipelined       ? openPipeline()
+                    : isNativeBackend ? openNativeSerial()
+                                      : openSerial();
+    if (!isOpened) {
+        requestStopDataSource();
+        return;
     }
 
-    tagToExit();
-    serial->close();
+    if (isStart)
+        emit controlWordReceived(currentSelectedChannel,
+                                 DataControlWords::DataStreamStart);
+
+#ifdef Q_OS_LINUX
+    if (pipeline != nullptr) {
+        // the pipeline reads and parses, this thread only dispatches
+        if (!pipeline->start(readerCore))
+            emit error(QString{"Can't pin the serial reader to core %1"}
+                           .arg(readerCore));
+        dispatchTimer->start();
+        statsTimer->start();
+        return;
+    }
+#endif
+
+    // from here on the event loop of this thread reads on readyRead
+    connect(latencyTimer, &QTimer::timeout, this,
+            &SerialWorker::readAvailable);
+#ifdef Q_OS_LINUX
+    if (readNotifier != nullptr)
+        connect(readNotifier, &QSocketNotifier::activated, this,
+                &SerialWorker::onReadyRead);
+    if (recheckTimer != nullptr)
+        connect(recheckTimer, &QTimer::timeout, this, [this]() {
+            // look at FIONREAD again, minReadSize may be there by now
+            if (latencyTimer->isActive() && !isTerminateSerial)
+                readNotifier->setEnabled(true);
+        });
+#endif
+    if (serial != nullptr)
+        connect(serial, &QSerialPort::readyRead, this,
+                &SerialWorker::onReadyRead);
+    if (bytesAvailable() > 0)
+        onReadyRead();
 }
 
-void SerialWorker::clearAllData() {
+void SerialWorker::requestStopDataSource() {
+    // closing the port calls back through aboutToClose
+    if (isStopped)
+        return;
+    isStopped = true;
+
+    DataSource::requestStopDataSource();
+
+    if (latencyTimer != nullptr)
+        latencyTimer->stop();
+    if (serial != nullptr && serial->isOpen())
+        serial->close();
+#ifdef Q_OS_LINUX
+    if (pipeline != nullptr) {
+        dispatchTimer->stop();
+        statsTimer->stop();
+        pipeline->stop();
+        logPipelineStats();
+    }
+    if (recheckTimer != nullptr)
+        recheckTimer->stop();
+    if (readNotifier != nullptr)
+        readNotifier->setEnabled(false);
+    if (nativePort != nullptr && nativePort->isOpen()) {
+        printCurrentTime() << "SerialWorker: native port read" << readBytes
+                           << "bytes in" << readCount << "reads";
+        if (readCount > 0)
+            printCurrentTime()
+                << "SerialWorker: last read" << lastRead.bytes << "bytes"
+                << millisecondsSince(lastRead.timestamp) << "ms ago";
+        nativePort->close();
+    }
+#endif
+
+    emit finished();
+    printCurrentTime() << "SerialWorker::run() end";
+}
+
+void SerialWorker::onReadyRead() {
     QMutexLocker locker{&mutex};
-    x.clear();
-    x.append(0.0);
+    auto minReadSize = settings.minReadSize;
+    locker.unlock();
+
+    if (!isPortOpen())
+        return;
 
-    step.clear();
-    step.append(1.0);
+    // a hang up shows up as readable with nothing to read
+    if (bytesAvailable() >= minReadSize || bytesAvailable() == 0) {
+        readAvailable();
+        return;
+    }
 
-    currentSelectIndex = 0;
+    // the rest of a short read may never come, the timer bounds the wait
+    if (!latencyTimer->isActive())
+        latencyTimer->start();
+#ifdef Q_OS_LINUX
+    // the notifier fires as long as the bytes sit there, mute it for a
+    // moment instead of spinning on it
+    if (readNotifier != nullptr) {
+        readNotifier->setEnabled(false);
+        recheckTimer->start();
+    }
+#endif
+}
+
+void SerialWorker::readAvailable() {
+    latencyTimer->stop();
+#ifdef Q_OS_LINUX
+    if (recheckTimer != nullptr)
+        recheckTimer->stop();
+#endif
+    if (isTerminateSerial || !isPortOpen())
+        return;
+
+    auto bytes = readPort();
+#ifdef Q_OS_LINUX
+    if (readNotifier != nullptr && !isTerminateSerial)
+        readNotifier->setEnabled(true);
+#endif
+    if (bytes == 0)
+        return;
+
+    if (!isStart) {
+        isStart = DataStreamParser::seekStartFlag();
+        if (!isStart)
+            return;
+    }
+
+    while (parseDataAndSend())
+        ;
+}
+
+bool SerialWorker::parseDataAndSend() {
+    // points before a control word belong to the current channel, parse
+    // them straight into its pending block
+    auto result = parseData(DataSource::channelBuffer(currentSelectedChannel));
+
+    if (result == std::nullopt) {
+        return false;
+    }
+
+    switch (result->first) {
+        case DataStreamParser::RDataType::RDataControlWord: {
+            auto [controlWord, controlWordData] =
+                DataSource::parseControlWord(result->second.toByteArray());
+            emit controlWordReceived(currentSelectedChannel, controlWord,
+                                     controlWordData);
+        } break;
+
+        case DataStreamParser::RDataType::RDataErrorString: {
+            emit error(result->second.toString());
+        } break;
+    }
+
+    return true;
+}
+
+void SerialWorker::clearAllData() {
+    QMutexLocker locker{&mutex};
+    resetChannels();
+#ifdef Q_OS_LINUX
+    if (pipeline != nullptr && !isDispatching)
+        pipeline->requestReset();
+#endif
 
     DataSource::clearAllData();
 }
@@ -325,16 +708,11 @@ void SerialWorker::onControlWordReceived(qsizetype index,
                                          QByteArray data) {
     switch (words) {
         case DataControlWords::SetXAxisStep: {
-            step[currentSelectIndex] = data.toDouble();
+            setChannelStep(data.toDouble());
         } break;
 
         case DataControlWords::SlelectSubplot: {
-            currentSelectIndex = data.toInt();
-
-            if (currentSelectIndex >= step.size()) {
-                step.append(1.0);
-                x.append(0.0);
-            }
+            selectChannel(data.toInt());
         } break;
 
         default:
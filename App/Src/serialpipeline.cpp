@@ -0,0 +1,244 @@
+/**
+ * @file serialpipeline.cpp
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#include "serialpipeline.h"
+
+#ifdef Q_OS_LINUX
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <utility>
+
+SerialPipeline::SerialPipeline(std::unique_ptr<TermiosPort> port,
+                               const DataSource* source,
+                               DataStreamParser::SourceType type,
+                               bool isStarted)
+    : port{std::move(port)},
+      source{source},
+      parser{type},
+      block{std::make_shared<SampleBlock>()},
+      isStarted{isStarted} {
+    parser.resetChannels();
+}
+
+SerialPipeline::~SerialPipeline() { stop(); }
+
+bool SerialPipeline::start(int readerCore) {
+    reader = std::jthread{[this](std::stop_token stopToken) {
+        readLoop(stopToken);
+    }};
+    parserThread = std::jthread{[this](std::stop_token stopToken) {
+        parseLoop(stopToken);
+    }};
+
+    if (readerCore < 0)
+        return true;
+    if (readerCore >= CPU_SETSIZE)
+        return false;
+
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    CPU_SET(readerCore, &cores);
+    return ::pthread_setaffinity_np(reader.native_handle(), sizeof(cores),
+                                    &cores) == 0;
+}
+
+void SerialPipeline::stop() {
+    reader.request_stop();
+    parserThread.request_stop();
+    if (reader.joinable())
+        reader.join();
+    if (parserThread.joinable())
+        parserThread.join();
+
+    while (pop() != nullptr)
+        ;
+    port->close();
+}
+
+std::unique_ptr<SerialPipeline::Item> SerialPipeline::pop() {
+    Item* item;
+    if (items.pop(&item, 1) == 0)
+        return nullptr;
+
+    increase(dispatchedItems);
+    return std::unique_ptr<Item>{item};
+}
+
+SerialPipeline::Stats SerialPipeline::stats() const {
+    constexpr auto relaxed = std::memory_order_relaxed;
+
+    return {
+        .reads = reads.load(relaxed),
+        .bytesRead = bytesRead.load(relaxed),
+        .readerStalls = readerStalls.load(relaxed),
+        .lastReadBytes = lastReadBytes.load(relaxed),
+        .lastReadTime = TermiosPort::Clock::time_point{
+            TermiosPort::Clock::duration{lastReadTime.load(relaxed)}},
+        .byteQueueSize = bytes.size(),
+        .byteQueuePeak = byteQueuePeak.load(relaxed),
+        .byteQueueCapacity = bytes.capacity(),
+        .parsedBytes = parsedBytes.load(relaxed),
+        .parserIdles = parserIdles.load(relaxed),
+        .parserStalls = parserStalls.load(relaxed),
+        .itemQueueSize = items.size(),
+        .itemQueuePeak = itemQueuePeak.load(relaxed),
+        .itemQueueCapacity = items.capacity(),
+        .dispatchedItems = dispatchedItems.load(relaxed),
+    };
+}
+
+void SerialPipeline::readLoop(std::stop_token stopToken) {
+    while (!stopToken.stop_requested()) {
+        std::size_t size;
+        auto data = bytes.writeSpan(size);
+        if (size == 0) {
+            // the parser is behind, the tty buffer takes up the slack
+            increase(readerStalls);
+            std::this_thread::sleep_for(backoff);
+            continue;
+        }
+
+        // returns after VTIME at the latest, to see stop requests
+        auto info = port->read(data, qint64(size));
+        if (info.bytes < 0) {
+            readerError = port->errorString();
+            isReaderFailed.store(true, std::memory_order_release);
+            return;
+        }
+        // nothing within VTIME, a hang up came back as an error above
+        if (info.bytes == 0)
+            continue;
+
+        bytes.commit(info.bytes);
+        increase(reads);
+        increase(bytesRead, info.bytes);
+        lastReadBytes.store(info.bytes, std::memory_order_relaxed);
+        lastReadTime.store(info.timestamp.time_since_epoch().count(),
+                           std::memory_order_relaxed);
+        updatePeak(byteQueuePeak, bytes.size());
+    }
+}
+
+void SerialPipeline::parseLoop(std::stop_token stopToken) {
+    while (!stopToken.stop_requested()) {
+        if (isResetRequested.exchange(false, std::memory_order_acq_rel)) {
+            flushBlock(stopToken);
+            applyControlWord(DataSource::DataStreamStart, {});
+        }
+
+        auto size = bytes.size();
+        if (size == 0) {
+            if (isReaderFailed.load(std::memory_order_acquire)) {
+                flushBlock(stopToken);
+                push(std::make_unique<Item>(Item{.kind = Item::PortError,
+                                                 .errorString = readerError}),
+                     stopToken);
+                return;
+            }
+
+            increase(parserIdles);
+            std::this_thread::sleep_for(backoff);
+            continue;
+        }
+
+        size = bytes.pop(parser.prepareData(qsizetype(size)), size);
+        parser.commitData(qsizetype(size));
+        increase(parsedBytes, qint64(size));
+
+        if (!isStarted) {
+            isStarted = parser.seekStartFlag();
+            if (!isStarted)
+                continue;
+        }
+
+        while (auto result = parser.parseData(*block)) {
+            // samples before the control word belong to the old channel
+            flushBlock(stopToken);
+
+            using RDataType = DataStreamParser::RDataType;
+            if (result->first == RDataType::RDataErrorString) {
+                push(std::make_unique<Item>(
+                         Item{.kind = Item::ErrorString,
+                              .errorString = result->second.toString()}),
+                     stopToken);
+                continue;
+            }
+
+            auto [words, data] =
+                source->parseControlWord(result->second.toByteArray());
+            applyControlWord(words, data);
+            push(std::make_unique<Item>(Item{.kind = Item::ControlWord,
+                                             .controlWord = words,
+                                             .data = data}),
+                 stopToken);
+        }
+        flushBlock(stopToken);
+    }
+}
+
+void SerialPipeline::flushBlock(std::stop_token& stopToken) {
+    if (block->isEmpty())
+        return;
+
+    // the next block starts with the capacity of this one
+    auto batchSize = block->size();
+    auto channel = parser.selectedChannel();
+    auto full = std::exchange(block, std::make_shared<SampleBlock>(channel));
+    block->reserve(batchSize);
+
+    push(std::make_unique<Item>(Item{.kind = Item::Samples,
+                                     .channel = full->channel(),
+                                     .block = std::move(full)}),
+         stopToken);
+}
+
+void SerialPipeline::applyControlWord(DataSource::DataControlWords words,
+                                      const QByteArray& data) {
+    // what SerialWorker does with the parser state, the rest is up to the
+    // dispatch stage
+    switch (words) {
+        case DataSource::DataStreamStart:
+            parser.resetChannels();
+            break;
+
+        case DataSource::SlelectSubplot:
+            parser.selectChannel(data.toInt());
+            break;
+
+        case DataSource::SetXAxisStep:
+            parser.setChannelStep(data.toDouble());
+            break;
+
+        default:
+            break;
+    }
+
+    if (block->channel() != parser.selectedChannel())
+        block = std::make_shared<SampleBlock>(parser.selectedChannel());
+}
+
+void SerialPipeline::push(std::unique_ptr<Item> item,
+                          std::stop_token& stopToken) {
+    auto raw = item.get();
+    while (items.push(&raw, 1) == 0) {
+        if (stopToken.stop_requested())
+            return;
+
+        // the dispatch stage is behind
+        increase(parserStalls);
+        std::this_thread::sleep_for(backoff);
+    }
+
+    item.release();
+    updatePeak(itemQueuePeak, items.size());
+}
+
+#endif /* Q_OS_LINUX */
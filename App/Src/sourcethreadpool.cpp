@@ -0,0 +1,70 @@
+/**
+ * @file sourcethreadpool.cpp
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#include "sourcethreadpool.h"
+
+#include <QMetaObject>
+#include <algorithm>
+
+#include "pch.h"
+
+SourceThreadPool::SourceThreadPool(QString name, int threadCount,
+                                   QObject* parent)
+    : QObject{parent}, poolName{name} {
+    threadCount = std::max(threadCount, 1);
+    for (auto i = 0; i < threadCount; ++i) {
+        auto thread = new QThread{this};
+        thread->setObjectName(QString{"%1 %2"}.arg(poolName).arg(i));
+        threads.append(thread);
+        load.insert(thread, 0);
+    }
+
+    printCurrentTime() << "SourceThreadPool" << poolName << "with"
+                       << threadCount << "threads";
+}
+
+SourceThreadPool::~SourceThreadPool() {
+    for (auto thread : threads) {
+        if (!thread->isRunning())
+            continue;
+
+        // wakes a source blocked on a stream nobody drains anymore
+        thread->requestInterruption();
+        thread->quit();
+        thread->wait();
+
+        printCurrentTime() << "Thread" << thread->objectName()
+                           << "is exited.";
+    }
+}
+
+void SourceThreadPool::start(DataSource* source) { start(QVector{source}); }
+
+void SourceThreadPool::start(const QVector<DataSource*>& sources) {
+    auto thread = leastLoadedThread();
+    if (!thread->isRunning())
+        thread->start();
+
+    for (auto source : sources) {
+        ++load[thread];
+
+        connect(thread, &QThread::finished, source, &DataSource::deleteLater);
+        connect(source, &QObject::destroyed, this,
+                [this, thread]() { --load[thread]; });
+
+        source->moveToThread(thread);
+        QMetaObject::invokeMethod(source, &DataSource::run,
+                                  Qt::QueuedConnection);
+    }
+}
+
+QThread* SourceThreadPool::leastLoadedThread() {
+    return *std::ranges::min_element(
+        threads, {}, [this](QThread* thread) { return load[thread]; });
+}
@@ -0,0 +1,61 @@
+/**
+ * @file spectrogramdatasource.cpp
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#include "spectrogramdatasource.h"
+
+#include <algorithm>
+
+SpectrogramDataSource::SpectrogramDataSource(DataSource const* spectrumSource,
+                                             qsizetype spectrumChannel,
+                                             QObject* parent)
+    : spectrumChannel{spectrumChannel}, DataSource{parent} {
+    // spectrum sources publish one whole frame per dataReceived
+    connect(spectrumSource, &DataSource::dataReceived, this,
+            [this](qsizetype index, SampleBlockPtr block) {
+                if (index != this->spectrumChannel)
+                    return;
+
+                appendSpectrum(*block);
+            });
+}
+
+SpectrogramDataSource::~SpectrogramDataSource() {}
+
+void SpectrogramDataSource::run() {
+    // rows are produced from queued spectrum frames, nothing to poll
+}
+
+void SpectrogramDataSource::requestStopDataSource() {
+    DataSource::requestStopDataSource();
+    emit finished();
+}
+
+void SpectrogramDataSource::setMaxColumns(int columns) {
+    maxColumns = std::max(columns, 1);
+}
+
+void SpectrogramDataSource::appendSpectrum(const SampleBlock& spectrum) {
+    if (isTerminateSerial || spectrum.isEmpty())
+        return;
+
+    // pool bins so that a row never exceeds maxColumns cells
+    const auto* y = spectrum.y();
+    auto binsPerCell = (spectrum.size() + maxColumns - 1) / maxColumns;
+    auto columns = (spectrum.size() + binsPerCell - 1) / binsPerCell;
+
+    QVector<double> row(columns);
+    for (qsizetype cell = 0; cell < columns; ++cell) {
+        auto first = y + cell * binsPerCell;
+        auto last = std::min(first + binsPerCell, y + spectrum.size());
+        row[cell] = *std::max_element(first, last);
+    }
+
+    emit rowReceived(0, spectrum.xAt(0),
+                     spectrum.xAt((columns - 1) * binsPerCell), row);
+}
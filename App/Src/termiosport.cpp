@@ -0,0 +1,251 @@
+/**
+ * @file termiosport.cpp
+ * @author nmpassthf (nmpassthf@gmail.com)
+ * @brief
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) nmpassthf 2026
+ *
+ */
+#include "termiosport.h"
+
+#ifdef Q_OS_LINUX
+
+#include <fcntl.h>
+#include <linux/serial.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+namespace {
+QString errnoString() { return QString::fromLocal8Bit(std::strerror(errno)); }
+}  // namespace
+
+TermiosPort::~TermiosPort() { close(); }
+
+bool TermiosPort::open(const QString& path, const Config& config) {
+    close();
+
+    // without O_NONBLOCK open() may wait for carrier, CLOCAL isn't set yet
+    fd = ::open(path.toLocal8Bit().constData(),
+                O_RDWR | O_NOCTTY | O_CLOEXEC | O_NONBLOCK);
+    if (fd < 0)
+        return fail("Can't open " + path);
+
+    // no other process reads behind our back
+    if (::ioctl(fd, TIOCEXCL) < 0)
+        return fail("Can't lock " + path);
+
+    if (!configure(config))
+        return false;
+
+    isBlockingMode = config.isBlocking;
+    if (isBlockingMode &&
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) & ~O_NONBLOCK) < 0)
+        return fail("Can't switch to blocking reads");
+
+    if (config.isLowLatency) {
+        setLowLatency();
+        setUsbLatencyTimer(path);
+    }
+
+    // drop what piled up before the port was set up
+    ::tcflush(fd, TCIFLUSH);
+    return true;
+}
+
+void TermiosPort::close() {
+    if (fd < 0)
+        return;
+
+    ::close(fd);
+    fd = -1;
+    isLowLatencySet = false;
+}
+
+bool TermiosPort::configure(const Config& config) {
+    termios tio;
+    if (::tcgetattr(fd, &tio) < 0)
+        return fail("tcgetattr");
+
+    // no echo, no line editing, no translation of CR/LF, 8 bit clean
+    ::cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+
+    auto speed = speedOf(config.baudRate);
+    if (speed == 0) {
+        lastError = QString{"Unsupported baud rate %1"}.arg(config.baudRate);
+        close();
+        return false;
+    }
+    ::cfsetispeed(&tio, speed);
+    ::cfsetospeed(&tio, speed);
+
+    tio.c_cflag &= ~CSIZE;
+    switch (config.dataBits) {
+        case 5:
+            tio.c_cflag |= CS5;
+            break;
+        case 6:
+            tio.c_cflag |= CS6;
+            break;
+        case 7:
+            tio.c_cflag |= CS7;
+            break;
+        default:
+            tio.c_cflag |= CS8;
+            break;
+    }
+
+    tio.c_cflag &= ~(PARENB | PARODD);
+    if (config.parity == EvenParity)
+        tio.c_cflag |= PARENB;
+    else if (config.parity == OddParity)
+        tio.c_cflag |= PARENB | PARODD;
+
+    if (config.isTwoStopBits)
+        tio.c_cflag |= CSTOPB;
+    else
+        tio.c_cflag &= ~CSTOPB;
+
+    if (config.isHardwareFlowControl)
+        tio.c_cflag |= CRTSCTS;
+    else
+        tio.c_cflag &= ~CRTSCTS;
+
+    if (config.isSoftwareFlowControl)
+        tio.c_iflag |= IXON | IXOFF;
+    else
+        tio.c_iflag &= ~(IXON | IXOFF | IXANY);
+
+    tio.c_cc[VMIN] = cc_t(std::clamp(config.vmin, 0, 255));
+    tio.c_cc[VTIME] = cc_t(std::clamp(config.vtime, 0, 255));
+
+    if (::tcsetattr(fd, TCSANOW, &tio) < 0)
+        return fail("tcsetattr");
+    return true;
+}
+
+void TermiosPort::setLowLatency() {
+    // only real UARTs and USB serial drivers know it, ptys don't
+    serial_struct serial;
+    if (::ioctl(fd, TIOCGSERIAL, &serial) < 0)
+        return;
+
+    serial.flags |= ASYNC_LOW_LATENCY;
+    isLowLatencySet = ::ioctl(fd, TIOCSSERIAL, &serial) == 0;
+}
+
+void TermiosPort::setUsbLatencyTimer(const QString& path) {
+    char resolved[PATH_MAX];
+    if (::realpath(path.toLocal8Bit().constData(), resolved) == nullptr)
+        return;
+
+    auto name = std::strrchr(resolved, '/');
+    name = name == nullptr ? resolved : name + 1;
+
+    // only FTDI adapters have it, nothing to do if it isn't there
+    auto timerPath = QString{"/sys/bus/usb-serial/devices/%1/latency_timer"}
+                         .arg(QString::fromLocal8Bit(name));
+    auto timerFd = ::open(timerPath.toLocal8Bit().constData(),
+                          O_WRONLY | O_CLOEXEC);
+    if (timerFd < 0)
+        return;
+
+    [[maybe_unused]] auto written = ::write(timerFd, "1", 1);
+    ::close(timerFd);
+}
+
+qint64 TermiosPort::bytesAvailable() const {
+    int available = 0;
+    if (fd < 0 || ::ioctl(fd, FIONREAD, &available) < 0)
+        return 0;
+    return available;
+}
+
+TermiosPort::ReadInfo TermiosPort::read(char* data, qint64 maxSize) {
+    ssize_t n;
+    do {
+        n = ::read(fd, data, std::size_t(maxSize));
+    } while (n < 0 && errno == EINTR);
+    auto timestamp = Clock::now();
+
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return {0, timestamp};
+
+        // EIO once the adapter is unplugged
+        lastError = QString{"read: %1"}.arg(errnoString());
+        return {-1, timestamp};
+    }
+
+    // with O_NONBLOCK 0 means the line hung up, without it it may also be
+    // a VTIME timeout
+    if (n == 0 && maxSize > 0 && (!isBlockingMode || isHungUp())) {
+        lastError = "read: port hung up";
+        return {-1, timestamp};
+    }
+    return {n, timestamp};
+}
+
+bool TermiosPort::isHungUp() const {
+    pollfd pfd{.fd = fd, .events = POLLIN};
+    int ready;
+    do {
+        ready = ::poll(&pfd, 1, 0);
+    } while (ready < 0 && errno == EINTR);
+    if (ready <= 0)
+        return false;
+
+    if (pfd.revents & (POLLHUP | POLLERR | POLLNVAL))
+        return true;
+    // readable with nothing to read is end of file, unless bytes came in
+    // right after the read timed out
+    return (pfd.revents & POLLIN) && bytesAvailable() == 0;
+}
+
+qint64 TermiosPort::write(const char* data, qint64 size) {
+    ssize_t n;
+    do {
+        n = ::write(fd, data, std::size_t(size));
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        lastError = QString{"write: %1"}.arg(errnoString());
+    return n;
+}
+
+unsigned TermiosPort::speedOf(qint32 baudRate) {
+    constexpr std::pair<qint32, speed_t> speeds[] = {
+        {50, B50},           {75, B75},           {110, B110},
+        {134, B134},         {150, B150},         {200, B200},
+        {300, B300},         {600, B600},         {1200, B1200},
+        {1800, B1800},       {2400, B2400},       {4800, B4800},
+        {9600, B9600},       {19200, B19200},     {38400, B38400},
+        {57600, B57600},     {115200, B115200},   {230400, B230400},
+        {460800, B460800},   {500000, B500000},   {576000, B576000},
+        {921600, B921600},   {1000000, B1000000}, {1152000, B1152000},
+        {1500000, B1500000}, {2000000, B2000000}, {2500000, B2500000},
+        {3000000, B3000000}, {3500000, B3500000}, {4000000, B4000000},
+    };
+
+    auto it = std::ranges::find(speeds, baudRate,
+                                &std::pair<qint32, speed_t>::first);
+    return it == std::end(speeds) ? 0 : it->second;
+}
+
+bool TermiosPort::fail(const QString& what) {
+    lastError = QString{"%1: %2"}.arg(what, errnoString());
+    close();
+    return false;
+}
+
+#endif /* Q_OS_LINUX */